@@ -18,6 +18,8 @@
 #include "gtest/gtest.h"
 
 #include <crtdbg.h>
+#include <fcntl.h>
+#include <io.h>
 #include <stdint.h>
 #include <windows.h>
 
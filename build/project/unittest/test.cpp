@@ -147,6 +147,17 @@ TEST_F(MisoTest, BinaryReader_FromMemory)
     unittest_read(reader);
 }
 
+TEST_F(MisoTest, FileStream_ReadBlock)
+{
+    TEST_TRACE("");
+    auto expected = miso::StringUtils::ReadFile("test2.xml");
+    miso::FileStream stream("test2.xml");
+    std::vector<uint8_t> buffer(expected.size() + 100);
+    ASSERT_EQ(expected.size(), stream.ReadBlock(buffer.data(), buffer.size()));
+    EXPECT_EQ(expected, std::string(buffer.begin(), buffer.begin() + expected.size()));
+    EXPECT_EQ(0, stream.ReadBlock(buffer.data(), buffer.size()));
+}
+
 // TEST_F(MisoTest, BinaryReader_CloseAfter)
 //{
 //    const uint8_t data[] = { 0x00, 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF };
@@ -155,6 +166,69 @@ TEST_F(MisoTest, BinaryReader_FromMemory)
 //    EXPECT_EQ(false, reader.CanRead());
 //}
 
+TEST_F(MisoTest, BinaryView)
+{
+    TEST_TRACE("");
+#pragma pack(1)
+    struct Header {
+        miso::BigEndian<uint32_t> magic;
+        miso::LittleEndian<uint16_t> version;
+        miso::LittleEndian<float> scale;
+        miso::OffsetPtr<miso::CountedArray<miso::BigEndian<int16_t>>> values;
+    };
+#pragma pack()
+    const uint8_t data[] = {
+        0x4D, 0x49, 0x53, 0x4F,         // magic
+        0x02, 0x01,                     // version
+        0x00, 0x00, 0xC0, 0x3F,         // scale
+        0x04, 0x00, 0x00, 0x00,         // values
+        0x03, 0x00, 0x00, 0x00,         // values count
+        0x00, 0x01, 0xFF, 0xFE, 0x12, 0x34,
+    };
+    miso::MemoryStream stream(data, sizeof(data));
+    miso::BinaryView view(stream);
+    EXPECT_EQ(sizeof(data), view.GetSize());
+    EXPECT_EQ(nullptr, view.Get<Header>(sizeof(data) - sizeof(Header) + 1));
+
+    auto header = view.Get<Header>(0);
+    ASSERT_NE(nullptr, header);
+    EXPECT_EQ(0x4D49534FUL, header->magic);
+    EXPECT_EQ(0x0102, header->version);
+    EXPECT_EQ(1.5f, header->scale);
+    ASSERT_TRUE(static_cast<bool>(header->values));
+    auto values = view.Resolve(header->values);
+    ASSERT_NE(nullptr, values);
+    EXPECT_EQ(3, values->GetCount());
+    EXPECT_EQ(0x0001, (*values)[0]);
+    EXPECT_EQ(-2, (*values)[1]);
+    EXPECT_EQ(0x1234, (*values)[2]);
+    int sum = 0;
+    for (auto& value : values->GetView()) sum += value;
+    EXPECT_EQ(0x1234 - 1, sum);
+    EXPECT_EQ(3, view.ResolveArray(header->values).GetCount());
+    EXPECT_EQ(-2, (view.GetCountedArray<miso::BigEndian<int16_t>>(14)[1]));
+
+    // The count of the values is in the truncated range but the last value is not.
+    miso::BinaryView truncated_view(data, sizeof(data) - 1);
+    auto truncated_header = truncated_view.Get<Header>(0);
+    ASSERT_NE(nullptr, truncated_header);
+    EXPECT_NE(nullptr, truncated_view.Resolve(truncated_header->values));
+    EXPECT_TRUE(truncated_view.ResolveArray(truncated_header->values).IsEmpty());
+    EXPECT_TRUE(truncated_view.GetCountedArray<miso::BigEndian<int16_t>>(14).IsEmpty());
+    EXPECT_TRUE(truncated_view.GetCountedArray<miso::BigEndian<int16_t>>(20).IsEmpty());
+
+    auto words = view.GetArray<miso::LittleEndian<uint16_t>>(4, 2);
+    EXPECT_EQ(2, words.GetCount());
+    EXPECT_EQ(0x0102, words[0]);
+    EXPECT_TRUE(view.GetArray<miso::LittleEndian<uint16_t>>(21, 2).IsEmpty());
+
+    miso::LittleEndian<uint32_t> little = 0x01020304UL;
+    miso::BigEndian<uint32_t> big = 0x01020304UL;
+    EXPECT_EQ(0x04, reinterpret_cast<const uint8_t*>(&little)[0]);
+    EXPECT_EQ(0x01, reinterpret_cast<const uint8_t*>(&big)[0]);
+    EXPECT_EQ(0x01020304UL, big.Get());
+}
+
 TEST_F(MisoTest, BinaryReader_Misc)
 {
     TEST_TRACE("");
@@ -258,6 +332,159 @@ TEST_F(MisoTest, BinaryReader_Misc)
     }
 }
 
+TEST_F(MisoTest, Checksum)
+{
+    TEST_TRACE("");
+    EXPECT_EQ(0xE3069283UL, miso::Checksum::ComputeCrc32c("123456789", 9));
+    EXPECT_EQ(0x00000000UL, miso::Checksum::ComputeCrc32c("", 0));
+    EXPECT_EQ(0xEF46DB3751D8E999ULL, miso::Checksum::ComputeXxHash64("", 0));
+    EXPECT_EQ(0xD24EC4F1A98C6E5BULL, miso::Checksum::ComputeXxHash64("a", 1));
+    EXPECT_EQ(0x44BC2CF5AD770999ULL, miso::Checksum::ComputeXxHash64("abc", 3));
+    EXPECT_EQ(0xBEA9CA8199328908ULL, miso::Checksum::ComputeXxHash64("abc", 3, 1));
+
+    uint8_t data[1000];
+    for (size_t i = 0; i < sizeof(data); ++i) data[i] = static_cast<uint8_t>(i * 7 + 3);
+    EXPECT_EQ(0xDD2EDFF7UL, miso::Checksum::ComputeCrc32c(data + 0, sizeof(data)));
+    EXPECT_EQ(0x5F235FA033F1A3FBULL, miso::Checksum::ComputeXxHash64(data, sizeof(data)));
+
+    miso::Checksum crc(miso::ChecksumType::Crc32c);
+    miso::Checksum xxhash(miso::ChecksumType::XxHash64);
+    for (size_t offset = 0, size = 1; offset < sizeof(data); offset += size, size = size * 2 + 1) {
+        auto chunk_size = std::min(size, sizeof(data) - offset);
+        crc.Update(data + offset, chunk_size);
+        xxhash.Update(data + offset, chunk_size);
+    }
+    EXPECT_EQ(sizeof(data), xxhash.GetSize());
+    EXPECT_EQ(0xDD2EDFF7UL, crc.GetValue());
+    EXPECT_EQ(0x5F235FA033F1A3FBULL, xxhash.GetValue());
+    xxhash.Reset();
+    EXPECT_EQ(0xEF46DB3751D8E999ULL, xxhash.GetValue());
+}
+
+TEST_F(MisoTest, ChecksumStream)
+{
+    TEST_TRACE("");
+    uint8_t data[1000];
+    for (size_t i = 0; i < sizeof(data); ++i) data[i] = static_cast<uint8_t>(i * 7 + 3);
+    {
+        miso::MemoryStream stream(data, sizeof(data));
+        miso::ChecksumStream checksum_stream(stream, miso::ChecksumType::Crc32c);
+        miso::BinaryReader reader(checksum_stream);
+        reader.Read<uint32_t>();
+        reader.Peek<uint64_t>();
+        reader.SetPosition(2);
+        reader.Read<uint16_t>();
+        EXPECT_EQ(12, checksum_stream.GetCheckedSize());
+        auto buffer = reader.ReadBlock(sizeof(data));
+        EXPECT_EQ(sizeof(data) - 4, buffer.GetSize());
+        EXPECT_EQ(sizeof(data), checksum_stream.GetCheckedSize());
+        EXPECT_EQ(0xDD2EDFF7UL, checksum_stream.GetChecksum().GetValue());
+        EXPECT_TRUE(checksum_stream.Verify(0xDD2EDFF7UL));
+    }
+    {
+        miso::MemoryStream stream(data, sizeof(data));
+        miso::ChecksumStream checksum_stream(stream, miso::ChecksumType::XxHash64);
+        checksum_stream.Read();
+        checksum_stream.SetPosition(500);
+        EXPECT_EQ(1, checksum_stream.GetCheckedSize());
+        EXPECT_FALSE(checksum_stream.Verify(0));
+        EXPECT_EQ(500, checksum_stream.GetPosition());
+        EXPECT_TRUE(checksum_stream.Verify(0x5F235FA033F1A3FBULL));
+    }
+}
+
+TEST_F(MisoTest, StreamStats)
+{
+    TEST_TRACE("");
+    const uint8_t data[] = { 0x00, 0x01, 0x23, 0x45, 0x67, 0x89, 0xAB, 0xCD, 0xEF };
+    miso::StreamStats::ResetGlobal();
+    {
+        miso::BinaryReader reader(data, sizeof(data));
+        reader.Read<uint32_t>();
+        reader.Peek<uint16_t>();
+        auto& stats = reader.GetStats();
+#ifdef MISO_STREAM_STATS
+        EXPECT_EQ(6, stats.delivered_bytes);
+        EXPECT_EQ(1, stats.seek_count);
+        EXPECT_EQ(0, stats.os_read_bytes);
+#else // MISO_STREAM_STATS
+        EXPECT_EQ(0, stats.delivered_bytes);
+        EXPECT_EQ(0, stats.seek_count);
+#endif // MISO_STREAM_STATS
+    }
+    {
+        miso::BinaryReader reader("test.bin");
+        uint8_t buffer[100];
+        reader.ReadBlock(buffer, sizeof(buffer));
+        reader.SetPosition(4);
+        auto& stats = reader.GetStats();
+#ifdef MISO_STREAM_STATS
+        EXPECT_EQ(9, stats.delivered_bytes);
+        EXPECT_EQ(9, stats.os_read_bytes);
+        EXPECT_EQ(1, stats.refill_count);
+        EXPECT_EQ(1, stats.seek_count);
+        EXPECT_LE(1, stats.syscall_count);
+#else // MISO_STREAM_STATS
+        EXPECT_EQ(0, stats.os_read_bytes);
+        EXPECT_EQ(0, stats.syscall_count);
+#endif // MISO_STREAM_STATS
+    }
+    auto global = miso::StreamStats::GetGlobal();
+#ifdef MISO_STREAM_STATS
+    EXPECT_EQ(15, global.delivered_bytes);
+    EXPECT_EQ(2, global.seek_count);
+#else // MISO_STREAM_STATS
+    EXPECT_EQ(0, global.delivered_bytes);
+#endif // MISO_STREAM_STATS
+}
+
+TEST_F(MisoTest, PipeStream)
+{
+    TEST_TRACE("");
+    int fds[2];
+    ASSERT_EQ(0, _pipe(fds, 65536, _O_BINARY));
+    static uint8_t data[40000];
+    for (size_t i = 0; i < sizeof(data); ++i) data[i] = static_cast<uint8_t>(i);
+    EXPECT_EQ(sizeof(data), _write(fds[1], data, sizeof(data)));
+    _close(fds[1]);
+
+    miso::PipeStream stream(fds[0], 16, true);
+    EXPECT_EQ(miso::IStream::kUnknownSize, stream.GetSize());
+    EXPECT_TRUE(stream.CanRead(8));
+    EXPECT_EQ(0, stream.Peek());
+    EXPECT_EQ(0, stream.Read());
+    EXPECT_EQ(1, stream.GetPosition());
+
+    uint8_t buffer[100];
+    EXPECT_EQ(100, stream.ReadBlock(buffer, sizeof(buffer)));
+    EXPECT_EQ(1, buffer[0]);
+    EXPECT_EQ(100, buffer[99]);
+
+    // Rewind within the window
+    stream.SetPosition(95);
+    EXPECT_EQ(95, stream.GetPosition());
+    EXPECT_EQ(95, stream.Read());
+
+    // Skip forward, then rewind beyond the window
+    stream.SetPosition(30000);
+    EXPECT_EQ(30000, stream.GetPosition());
+    EXPECT_EQ(static_cast<uint8_t>(30000), stream.Peek());
+    stream.SetPosition(0);
+    EXPECT_LT(0, stream.GetPosition());
+    EXPECT_EQ(static_cast<uint8_t>(stream.GetPosition()), stream.Peek());
+    stream.SetPosition(29990);
+    EXPECT_EQ(29990, stream.GetPosition());
+    EXPECT_EQ(static_cast<uint8_t>(29990), stream.Read());
+
+    // Read to the end across the ring boundary
+    static uint8_t rest[sizeof(data)];
+    EXPECT_EQ(sizeof(data) - 29991, stream.ReadBlock(rest, sizeof(rest)));
+    EXPECT_EQ(0, std::memcmp(rest, data + 29991, sizeof(data) - 29991));
+    EXPECT_FALSE(stream.CanRead());
+    EXPECT_EQ(sizeof(data), stream.GetSize());
+    EXPECT_EQ(0, stream.ReadBlock(rest, sizeof(rest)));
+}
+
 TEST_F(MisoTest, StringUtils_ReadWrite)
 {
     TEST_TRACE("");
@@ -496,6 +723,28 @@ TEST_F(MisoTest, Buffer_Empty)
     EXPECT_EQ(100, a.GetSize());
 }
 
+TEST_F(MisoTest, Buffer_HugePageAllocator)
+{
+    TEST_TRACE("");
+    using HugePageBuffer = miso::Buffer<miso::HugePageAllocator<uint8_t>>;
+    HugePageBuffer small(100);
+    EXPECT_EQ(100, small.GetSize());
+    small[99] = 99;
+    EXPECT_EQ(99, small[99]);
+
+    const size_t large_size = miso::HugePageUtils::kHugePageSize * 2 + 1;
+    HugePageBuffer large(large_size);
+    EXPECT_EQ(large_size, large.GetSize());
+    large[0] = 1;
+    large[large_size - 1] = 2;
+    small.Resize(large_size);
+    EXPECT_EQ(99, small[99]);
+    small[large_size - 1] = 3;
+    EXPECT_EQ(3, small[large_size - 1]);
+    EXPECT_EQ(1, large[0]);
+    EXPECT_EQ(2, large[large_size - 1]);
+}
+
 TEST_F(MisoTest, XmlReader_Normal)
 {
     TEST_TRACE("");
@@ -574,6 +823,123 @@ TEST_F(MisoTest, XmlReader_Normal)
     EXPECT_EQ(false, reader.HasError());
 }
 
+TEST_F(MisoTest, XmlReader_View)
+{
+    TEST_TRACE("");
+    miso::XmlReader reader("test.xml");
+    EXPECT_TRUE(reader.GetElementNameView().empty());
+    EXPECT_EQ(nullptr, reader.GetAttributeValueView("name").data());
+
+    EXPECT_TRUE(reader.Read());
+    EXPECT_EQ("root", reader.GetElementNameView());
+    EXPECT_EQ("root_name", reader.GetAttributeValueView("name"));
+    EXPECT_EQ(nullptr, reader.GetAttributeValueView("type").data());
+    EXPECT_TRUE(reader.GetContentTextView().empty());
+
+    EXPECT_TRUE(reader.MoveToElement("element", "id", "element2"));
+    EXPECT_EQ("element", reader.GetElementNameView());
+    auto id = reader.GetAttributeValueView("id");
+    auto name = reader.GetAttributeValueView("name");
+    EXPECT_EQ("element2", id);
+    EXPECT_EQ("element2_name", name);
+    EXPECT_EQ(miso::XmlNodeType::StartElement, reader.GetNodeType());
+    EXPECT_EQ(1, reader.GetNestingLevel());
+
+    EXPECT_TRUE(reader.Read());
+    EXPECT_EQ("\n    TEXT1\n    ", reader.GetContentTextView());
+    EXPECT_TRUE(reader.GetElementNameView().empty());
+    EXPECT_EQ(nullptr, reader.GetAttributeValueView("id").data());
+
+    EXPECT_TRUE(reader.Read());
+    EXPECT_EQ("sub", reader.GetAttributeValueView("type"));
+    EXPECT_TRUE(reader.Read());
+    EXPECT_EQ("TEXT2", reader.GetContentTextView());
+    EXPECT_TRUE(reader.Read());
+    EXPECT_EQ(miso::XmlNodeType::EndElement, reader.GetNodeType());
+    EXPECT_EQ("sub-element", reader.GetElementNameView());
+}
+
+TEST_F(MisoTest, XmlReader_AttributeCursor)
+{
+    TEST_TRACE("");
+    miso::XmlReader reader("test2.xml");
+    EXPECT_FALSE(reader.GetAttributeCursor().Next());
+    ASSERT_TRUE(reader.MoveToElement(nullptr, "id", "element2.4"));
+    {
+        std::vector<std::string> visited;
+        for (auto cursor = reader.GetAttributeCursor(); cursor.Next();) {
+            visited.push_back(std::string(cursor.GetName()) + "=" + std::string(cursor.GetValue()));
+        }
+        ASSERT_EQ(2, visited.size());
+        EXPECT_EQ("id=element2.4", visited[0]);
+        EXPECT_EQ("tag=y", visited[1]);
+    }
+    EXPECT_EQ("element", reader.GetElementName());
+    {
+        miso::XmlAttributeFilter filter({ "name", "tag" });
+        auto cursor = reader.GetAttributeCursor(&filter);
+        EXPECT_TRUE(cursor.Next());
+        EXPECT_EQ("tag", cursor.GetName());
+        EXPECT_EQ("y", cursor.GetValue());
+        EXPECT_EQ(1, cursor.GetFilterIndex());
+        EXPECT_FALSE(cursor.Next());
+        EXPECT_EQ(miso::XmlAttributeFilter::kNotFound, cursor.GetFilterIndex());
+    }
+    {
+        // Leaving the loop early
+        for (auto cursor = reader.GetAttributeCursor(); cursor.Next();) break;
+        EXPECT_EQ("element", reader.GetElementName());
+        EXPECT_EQ("y", reader.GetAttributeValueView("tag"));
+    }
+    EXPECT_TRUE(reader.Read());
+    EXPECT_EQ("element2.4.1", reader.GetAttributeValueView("id"));
+    EXPECT_TRUE(reader.Read());
+    EXPECT_EQ(miso::XmlNodeType::Text, reader.GetNodeType());
+    EXPECT_FALSE(reader.GetAttributeCursor().Next());
+}
+
+TEST_F(MisoTest, XmlReader_Atom)
+{
+    TEST_TRACE("");
+    miso::XmlReader reader("test2.xml");
+    auto element = reader.Intern("element");
+    auto root = reader.Intern("root");
+    EXPECT_FALSE(element.IsNull());
+    EXPECT_EQ("element", element.GetName());
+    EXPECT_EQ(element, reader.Intern(std::string("element").c_str()));
+    EXPECT_NE(element, root);
+    EXPECT_TRUE(reader.GetElementAtom().IsNull());
+    {
+        EXPECT_TRUE(reader.MoveToElement(root));
+        EXPECT_EQ(root, reader.GetElementAtom());
+        EXPECT_TRUE(reader.MoveToElement(element));
+        EXPECT_EQ(element, reader.GetElementAtom());
+        EXPECT_EQ("element1", reader.GetAttributeValueString("id"));
+        EXPECT_TRUE(reader.MoveToElement(element, "id", "element2.4"));
+        EXPECT_EQ("element", reader.GetElementName());
+    }
+    {
+        auto tag = reader.Intern("tag");
+        bool found = false;
+        for (auto cursor = reader.GetAttributeCursor(); cursor.Next();) {
+            if (cursor.GetNameAtom() == tag) found = true;
+        }
+        EXPECT_TRUE(found);
+    }
+    {
+        std::vector<std::string> ids;
+        while (reader.MoveToElementInCurrentLevel(element)) {
+            ids.push_back(reader.GetAttributeValueString("id"));
+            reader.MoveToEndElement();
+        }
+        ASSERT_EQ(2, ids.size());
+        EXPECT_EQ("element2.5", ids[0]);
+        EXPECT_EQ("element2.6", ids[1]);
+        EXPECT_EQ(miso::XmlNodeType::EndElement, reader.GetNodeType());
+        EXPECT_EQ(element, reader.GetElementAtom());
+    }
+}
+
 TEST_F(MisoTest, XmlReader_MoveToElement)
 {
     TEST_TRACE("");
@@ -739,6 +1105,1224 @@ TEST_F(MisoTest, XmlReader_MoveToEndOfParentElement)
     }
 }
 
+TEST_F(MisoTest, XmlReader_SkipSubtree)
+{
+    TEST_TRACE("");
+    miso::XmlReader reader("test2.xml");
+    EXPECT_TRUE(reader.MoveToElement("element", "id", "element2.1"));
+    EXPECT_TRUE(reader.SkipSubtree());
+    EXPECT_EQ(miso::XmlNodeType::EmptyElement, reader.GetNodeType());
+    EXPECT_EQ("element2.2", reader.GetAttributeValueString("id"));
+    EXPECT_TRUE(reader.SkipSubtree());
+    EXPECT_EQ("element2.3", reader.GetAttributeValueString("id"));
+    EXPECT_TRUE(reader.SkipSubtree());
+    EXPECT_TRUE(reader.SkipSubtree());
+    EXPECT_EQ(miso::XmlNodeType::StartElement, reader.GetNodeType());
+    EXPECT_EQ("element2.5", reader.GetAttributeValueString("id"));
+    EXPECT_TRUE(reader.SkipSubtree());
+    EXPECT_TRUE(reader.SkipSubtree());
+    EXPECT_EQ(miso::XmlNodeType::EndElement, reader.GetNodeType());
+    EXPECT_TRUE(reader.MoveToEndOfParentElement());
+    EXPECT_EQ("root", reader.GetElementName());
+    EXPECT_FALSE(reader.SkipSubtree());
+    EXPECT_FALSE(reader.CanRead());
+}
+
+// Document shaped like a generated API reference, in which most 'member' elements are skipped.
+static std::string
+MakeMembersXml(int member_count)
+{
+    std::string xml = "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<doc><assembly><name>Test</name></assembly><members>\n";
+    for (int i = 0; i < member_count; ++i) {
+        xml += miso::StringUtils::Format(
+            "<member name=\"M:Test.Member%d\"><summary>Summary of member %d.</summary>"
+            "<param name=\"value\">Value.</param><returns>Result.</returns></member>\n", i, i);
+    }
+    xml += "</members></doc>\n";
+    return xml;
+}
+
+template<typename TReader> static int
+ReadMembersXml(const std::string& xml, bool skip_subtree)
+{
+    int visited_count = 0;
+    TReader reader(xml.data(), xml.length());
+    bool moved = reader.Read();
+    while (moved) {
+        if (reader.GetNodeType() == miso::XmlNodeType::StartElement) {
+            auto name = reader.GetElementNameView();
+            if (name != "doc" &&
+                name != "members" &&
+                (name != "member" ||
+                    reader.GetAttributeValueView("name") != "M:Test.Member5")) {
+                if (skip_subtree) {
+                    moved = reader.SkipSubtree();
+                } else {
+                    moved = reader.MoveToEndElement() && reader.Read();
+                }
+                continue;
+            }
+            ++visited_count;
+        }
+        moved = reader.Read();
+    }
+    return visited_count;
+}
+
+TEST_F(MisoTest, XmlReader_SkipMembers)
+{
+    TEST_TRACE("");
+    auto xml = MakeMembersXml(10);
+    EXPECT_EQ(3, ReadMembersXml<miso::XmlReader>(xml, false));
+    EXPECT_EQ(3, ReadMembersXml<miso::XmlReader>(xml, true));
+}
+
+// Skip Performance
+// Compare the times of the two tests.
+#if 0
+TEST_F(MisoTest, XmlReader_SkipPerformance_MoveToEndElement)
+{
+    TEST_TRACE("");
+    auto xml = MakeMembersXml(20000);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(3, ReadMembersXml<miso::XmlReader>(xml, false));
+    }
+}
+
+TEST_F(MisoTest, XmlReader_SkipPerformance_SkipSubtree)
+{
+    TEST_TRACE("");
+    auto xml = MakeMembersXml(20000);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(3, ReadMembersXml<miso::XmlReader>(xml, true));
+    }
+}
+#endif
+
+static std::vector<std::string>
+SelectIds(miso::XmlReader& reader, const char* selector_text)
+{
+    std::vector<std::string> ids;
+    miso::XmlSelector selector(selector_text);
+    miso::XmlSelection selection(reader, selector);
+    while (selection.Next()) {
+        ids.push_back(reader.GetAttributeValueString("id"));
+    }
+    return ids;
+}
+
+TEST_F(MisoTest, XmlSelector)
+{
+    TEST_TRACE("");
+    {
+        EXPECT_TRUE(miso::XmlSelector("element[@tag='*'] > element").IsValid());
+        EXPECT_TRUE(miso::XmlSelector(" > root>element[ @id = \"x\" ][@tag] * ").IsValid());
+        EXPECT_FALSE(miso::XmlSelector("").IsValid());
+        EXPECT_FALSE(miso::XmlSelector("element >").IsValid());
+        EXPECT_FALSE(miso::XmlSelector("element[tag]").IsValid());
+        EXPECT_FALSE(miso::XmlSelector("element[@tag='*]").IsValid());
+        EXPECT_EQ("'@' expected at 8 in \"element[tag]\"", miso::XmlSelector("element[tag]").GetError());
+    }
+    {
+        miso::XmlReader reader("test2.xml");
+        auto ids = SelectIds(reader, "element[@tag='*'] > element");
+        ASSERT_EQ(3, ids.size());
+        EXPECT_EQ("element3.1", ids[0]);
+        EXPECT_EQ("element3.3", ids[2]);
+        EXPECT_FALSE(reader.CanRead());
+    }
+    {
+        miso::XmlReader reader("test2.xml");
+        auto ids = SelectIds(reader, "> root > element");
+        ASSERT_EQ(3, ids.size());
+        EXPECT_EQ("element1", ids[0]);
+        EXPECT_EQ("element2", ids[1]);
+        EXPECT_EQ("element3", ids[2]);
+    }
+    {
+        miso::XmlReader reader("test2.xml");
+        auto ids = SelectIds(reader, "element element element[@id]");
+        ASSERT_EQ(8, ids.size());
+        EXPECT_EQ("element2.1.1", ids[0]);
+        EXPECT_EQ("element2.4.3", ids[4]);
+        EXPECT_EQ("element3.2.1", ids[7]);
+    }
+    {
+        miso::XmlReader reader("test2.xml");
+        auto ids = SelectIds(reader, "*[@tag='y'] *");
+        ASSERT_EQ(3, ids.size());
+        EXPECT_EQ("element2.4.1", ids[0]);
+    }
+    {
+        // Search in the current element, including nested selected elements
+        miso::XmlReader reader("test2.xml");
+        EXPECT_TRUE(reader.MoveToElement("element", "id", "element3"));
+        auto ids = SelectIds(reader, "element");
+        ASSERT_EQ(6, ids.size());
+        EXPECT_EQ("element3.1", ids[0]);
+        EXPECT_EQ("element3.1.1", ids[1]);
+        EXPECT_EQ("element3.3", ids[5]);
+        EXPECT_EQ(miso::XmlNodeType::EndElement, reader.GetNodeType());
+        EXPECT_EQ("element", reader.GetElementName());
+        EXPECT_TRUE(reader.Read());
+        EXPECT_EQ("root", reader.GetElementName());
+    }
+    {
+        // Moving the reader inside the selected element
+        miso::XmlReader reader("test2.xml");
+        miso::XmlSelector selector("element[@id='element3'] element");
+        miso::XmlSelection selection(reader, selector);
+        EXPECT_TRUE(selection.Next());
+        EXPECT_EQ("element3.1", reader.GetAttributeValueString("id"));
+        EXPECT_TRUE(reader.MoveToEndElement());
+        EXPECT_TRUE(selection.Next());
+        EXPECT_EQ("element3.2", reader.GetAttributeValueString("id"));
+        EXPECT_TRUE(reader.Read());
+        EXPECT_EQ("element3.2.1", reader.GetAttributeValueString("id"));
+        EXPECT_TRUE(selection.Next());
+        EXPECT_EQ("element3.3", reader.GetAttributeValueString("id"));
+        EXPECT_FALSE(selection.Next());
+    }
+    {
+        // Stepping inside a selected element after libxml has freed the nodes read before,
+        // whose memory may be reused for the nodes read next
+        for (int count = 0; count < 40; count++) {
+            std::string xml = "<r>";
+            for (int i = 0; i < count; i++) {
+                xml += "<w><p><q/></p></w>";
+            }
+            xml += "<x><y id='A'><m><y id='B'/></m><m2><k><y id='C'/></k></m2></y></x></r>";
+            miso::XmlReader reader(xml.data(), xml.size());
+            miso::XmlSelector selector("x y");
+            miso::XmlSelection selection(reader, selector);
+            std::string ids;
+            while (selection.Next()) {
+                ids += reader.GetAttributeValueString("id");
+                if (ids == "A") {
+                    EXPECT_TRUE(reader.Read());
+                }
+            }
+            EXPECT_EQ("ABC", ids) << count;
+        }
+    }
+}
+
+class TestSaxHandler : public miso::IXmlSaxHandler {
+public:
+    void OnStartElement(std::string_view name, miso::ArrayView<miso::XmlSaxAttribute> attributes)
+    {
+        std::string log = "<" + std::string(name);
+        for (auto& attribute : attributes) {
+            log += " " + std::string(attribute.name) + "='" + std::string(attribute.value) + "'";
+        }
+        logs.push_back(log + ">");
+    }
+    void OnEndElement(std::string_view name) { logs.push_back("</" + std::string(name) + ">"); }
+    void OnText(std::string_view text) { logs.push_back(miso::StringUtils::Trim(std::string(text))); }
+
+    std::vector<std::string> logs;
+};
+
+TEST_F(MisoTest, XmlSaxParser)
+{
+    TEST_TRACE("");
+    {
+        TestSaxHandler handler;
+        miso::XmlSaxParser parser(handler);
+        EXPECT_TRUE(parser.Parse("test.xml"));
+        EXPECT_FALSE(parser.HasError());
+        ASSERT_EQ(11, handler.logs.size());
+        EXPECT_EQ("<root name='root_name'>", handler.logs[0]);
+        EXPECT_EQ("<element id='element1'>", handler.logs[1]);
+        EXPECT_EQ("</element>", handler.logs[2]);
+        EXPECT_EQ("<element id='element2' name='element2_name'>", handler.logs[3]);
+        EXPECT_EQ("TEXT1", handler.logs[4]);
+        EXPECT_EQ("<sub-element type='sub'>", handler.logs[5]);
+        EXPECT_EQ("TEXT2", handler.logs[6]);
+        EXPECT_EQ("</sub-element>", handler.logs[7]);
+        EXPECT_EQ("TEXT3", handler.logs[8]);
+        EXPECT_EQ("</element>", handler.logs[9]);
+        EXPECT_EQ("</root>", handler.logs[10]);
+    }
+    {
+        const char xml[] = "<a xmlns:p='urn:p' p:x='1&amp;2'><p:b>x<![CDATA[<y>]]></p:b><c/></a>";
+        TestSaxHandler handler;
+        miso::XmlSaxParser parser(handler);
+        EXPECT_TRUE(parser.Parse(xml, sizeof(xml) - 1));
+        ASSERT_EQ(7, handler.logs.size());
+        EXPECT_EQ("<a p:x='1&2'>", handler.logs[0]);
+        EXPECT_EQ("<p:b>", handler.logs[1]);
+        EXPECT_EQ("x<y>", handler.logs[2]);
+        EXPECT_EQ("</p:b>", handler.logs[3]);
+        EXPECT_EQ("</a>", handler.logs[6]);
+    }
+    {
+        miso::MemoryStream stream(reinterpret_cast<const uint8_t*>("<a><b></a>"), 10);
+        TestSaxHandler handler;
+        miso::XmlSaxParser parser(handler);
+        EXPECT_FALSE(parser.Parse(stream));
+        EXPECT_TRUE(parser.HasError());
+        EXPECT_EQ(0, parser.GetErrors()[0].find("[ERROR] "));
+    }
+    {
+        struct StopHandler : public miso::IXmlSaxHandler {
+            void OnStartElement(std::string_view, miso::ArrayView<miso::XmlSaxAttribute>) { ++count; parser->Stop(); }
+            miso::XmlSaxParser* parser = nullptr;
+            int count = 0;
+        } handler;
+        miso::XmlSaxParser parser(handler);
+        handler.parser = &parser;
+        parser.Parse("test2.xml");
+        EXPECT_EQ(1, handler.count);
+    }
+    {
+        TestSaxHandler handler;
+        miso::XmlSaxParser parser(handler);
+        EXPECT_FALSE(parser.Parse("test_error_file_not_found.xml"));
+        EXPECT_EQ("Cannot open file", parser.GetErrors()[0]);
+    }
+}
+
+template<typename TReader> static std::string
+DumpXmlNodes(TReader& reader)
+{
+    static const char* types[] = { "None", "Start", "Empty", "End", "Text" };
+    std::string dump;
+    while (reader.Read()) {
+        dump += miso::StringUtils::Format("%d %s ", reader.GetNestingLevel(), types[static_cast<int>(reader.GetNodeType())]);
+        if (reader.GetNodeType() == miso::XmlNodeType::Text) {
+            dump += reader.GetContentText();
+        } else {
+            dump += reader.GetElementName();
+        }
+        for (auto& attribute : reader.GetAllAttributes()) {
+            dump += " " + attribute.GetName() + "=" + attribute.GetValue();
+        }
+        dump += "\n";
+    }
+    return dump;
+}
+
+template<typename TReader> static std::string
+NavigateXml(TReader& reader)
+{
+    std::string log;
+    auto record = [&](bool moved) {
+        log += miso::StringUtils::Format("%d %d %s %s\n", moved ? 1 : 0, static_cast<int>(reader.GetNodeType()),
+            reader.GetElementName().c_str(), reader.GetAttributeValueString("id").c_str());
+    };
+    record(reader.MoveToElement("element", "id", "element2"));
+    record(reader.MoveToElement("element"));
+    record(reader.MoveToElementInCurrentLevel(nullptr, "tag", "y"));
+    record(reader.MoveToElement("element"));
+    record(reader.MoveToEndOfParentElement());
+    record(reader.MoveToElementInCurrentLevel("element"));
+    record(reader.SkipSubtree());
+    record(reader.MoveToEndElement());
+    record(reader.MoveToElementInCurrentLevel("element", "tag"));
+    record(reader.MoveToElement(nullptr, "id", "element3.2.1"));
+    record(reader.MoveToEndOfParentElement());
+    record(reader.MoveToEndOfParentElement());
+    record(reader.MoveToElementInCurrentLevel());
+    record(reader.MoveToEndOfParentElement());
+    return log;
+}
+
+TEST_F(MisoTest, FastXmlReader)
+{
+    TEST_TRACE("");
+    for (auto filename : { "test.xml", "test2.xml" }) {
+        miso::XmlReader reader(filename);
+        miso::FastXmlReader fast_reader(filename);
+        EXPECT_EQ(DumpXmlNodes(reader), DumpXmlNodes(fast_reader));
+        EXPECT_FALSE(fast_reader.HasError());
+        EXPECT_FALSE(fast_reader.CanRead());
+    }
+    {
+        const char xml[] =
+            "\xEF\xBB\xBF<?xml version=\"1.0\"?>\n<!DOCTYPE a [ <!ELEMENT a ANY> ]>\n"
+            "<a x='&lt;&amp;&gt;' y=\"'&quot;&#65;&#x3042;\">1&lt;2<!-- <b> -->3<![CDATA[<c>]]>4<?pi x?>"
+            "<b z = '>' /> &apos;5&apos; </a>";
+        miso::XmlReader reader(xml, sizeof(xml) - 1);
+        miso::FastXmlReader fast_reader(xml, sizeof(xml) - 1);
+        auto dump = DumpXmlNodes(fast_reader);
+        EXPECT_EQ(DumpXmlNodes(reader), dump);
+        EXPECT_EQ("0 Start a x=<&> y='\"A\xE3\x81\x82\n1 Text 1<2\n1 Text 3\n1 Text 4\n1 Empty b z=>\n1 Text  '5' \n0 End a\n", dump);
+    }
+    {
+        miso::XmlReader reader("test2.xml");
+        miso::FastXmlReader fast_reader("test2.xml");
+        EXPECT_EQ(NavigateXml(reader), NavigateXml(fast_reader));
+    }
+    {
+        miso::FastXmlReader reader("test2.xml");
+        EXPECT_TRUE(reader.MoveToElement("element", "id", "element2.4"));
+        EXPECT_EQ("y", reader.GetAttributeValueView("tag"));
+        EXPECT_EQ(nullptr, reader.GetAttributeValueView("name").data());
+        EXPECT_EQ(2, reader.GetNestingLevel());
+    }
+    {
+        const char xml[] = "<a><b></a>";
+        miso::FastXmlReader reader(xml, sizeof(xml) - 1);
+        EXPECT_TRUE(reader.Read());
+        EXPECT_TRUE(reader.Read());
+        EXPECT_FALSE(reader.Read());
+        EXPECT_TRUE(reader.HasError());
+        EXPECT_EQ("[ERROR] Opening and ending tag mismatch: a", reader.GetErrors()[0]);
+    }
+    {
+        miso::FastXmlReader reader("test_error_file_not_found.xml");
+        EXPECT_FALSE(reader.CanRead());
+        EXPECT_FALSE(reader.Read());
+        EXPECT_TRUE(reader.HasError());
+    }
+}
+
+TEST_F(MisoTest, FastXmlReader_SkipMembers)
+{
+    TEST_TRACE("");
+    auto xml = MakeMembersXml(10);
+    EXPECT_EQ(3, ReadMembersXml<miso::FastXmlReader>(xml, true));
+    miso::XmlReader reader(xml.data(), xml.length());
+    miso::FastXmlReader fast_reader(xml.data(), xml.length());
+    EXPECT_EQ(DumpXmlNodes(reader), DumpXmlNodes(fast_reader));
+}
+
+// FastXmlReader Performance
+// Compare the time with XmlReader_SkipPerformance_SkipSubtree.
+#if 0
+TEST_F(MisoTest, FastXmlReader_Performance)
+{
+    TEST_TRACE("");
+    auto xml = MakeMembersXml(20000);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(3, ReadMembersXml<miso::FastXmlReader>(xml, true));
+    }
+}
+#endif
+
+TEST_F(MisoTest, BinaryXmlReader)
+{
+    TEST_TRACE("");
+    for (auto filename : { "test.xml", "test2.xml" }) {
+        miso::XmlReader reader(filename);
+        auto xml = miso::StringUtils::ReadFile(filename);
+        miso::BinaryXmlReader binary_reader(miso::BinaryXmlReader::Compile(xml.data(), xml.size()));
+        EXPECT_EQ(DumpXmlNodes(reader), DumpXmlNodes(binary_reader));
+        EXPECT_FALSE(binary_reader.HasError());
+        EXPECT_FALSE(binary_reader.CanRead());
+    }
+    {
+        auto xml = miso::StringUtils::ReadFile("test2.xml");
+        auto data = miso::BinaryXmlReader::Compile(xml.data(), xml.size());
+        miso::XmlReader reader("test2.xml");
+        miso::BinaryXmlReader binary_reader(data.data(), data.size());
+        EXPECT_EQ(NavigateXml(reader), NavigateXml(binary_reader));
+    }
+    {
+        const char xml[] = "<a n='10px' f='1.0' c='#ff0000' v='1 2' s='abc' e='&amp;'/>";
+        miso::BinaryXmlReader reader(miso::BinaryXmlReader::Compile(xml, sizeof(xml) - 1));
+        ASSERT_TRUE(reader.Read());
+        EXPECT_EQ(miso::Value("10px"), reader.GetAttributeValue("n"));
+        EXPECT_TRUE(reader.GetAttributeValue("f").AsNumeric().IsFloat());
+        EXPECT_EQ(miso::Value("#ff0000"), reader.GetAttributeValue("c"));
+        EXPECT_EQ(2, reader.GetAttributeValue("v").GetCount());
+        EXPECT_FALSE(reader.GetAttributeValue("s").IsValid());
+        EXPECT_FALSE(reader.GetAttributeValue("x").IsValid());
+        EXPECT_EQ("&", reader.GetAttributeValueView("e"));
+        EXPECT_EQ(nullptr, reader.GetAttributeValueView("x").data());
+    }
+    {
+        const char xml[] = "<a><b></a>";
+        EXPECT_TRUE(miso::BinaryXmlReader::Compile(xml, sizeof(xml) - 1).empty());
+        const uint8_t data[] = { 'M', 'X', 'B', 'C', 1, 0, 0, 0 };
+        miso::BinaryXmlReader reader(data, sizeof(data));
+        EXPECT_TRUE(reader.HasError());
+        EXPECT_FALSE(reader.Read());
+    }
+}
+
+TEST_F(MisoTest, BinaryXmlReader_Cache)
+{
+    TEST_TRACE("");
+    const char* filename = "test_binary_xml.ignore.xml";
+    const char* cache_filename = "test_binary_xml.ignore.mxb";
+    std::remove(cache_filename);
+    miso::StringUtils::WriteFile(filename, "<a><b id='1'/></a>");
+    bool compiled;
+    {
+        auto reader = miso::BinaryXmlReader::Open(filename, cache_filename, miso::BinaryXmlValidation::ModifiedTime, &compiled);
+        EXPECT_TRUE(compiled);
+        EXPECT_TRUE(reader.MoveToElement("b"));
+        EXPECT_EQ("1", reader.GetAttributeValueString("id"));
+    }
+    {
+        auto reader = miso::BinaryXmlReader::Open(filename, cache_filename, miso::BinaryXmlValidation::ModifiedTime, &compiled);
+        EXPECT_FALSE(compiled);
+        EXPECT_TRUE(reader.MoveToElement("b"));
+    }
+    miso::StringUtils::WriteFile(filename, "<a><b id='22'/></a>");
+    {
+        auto reader = miso::BinaryXmlReader::Open(filename, cache_filename, miso::BinaryXmlValidation::ModifiedTime, &compiled);
+        EXPECT_TRUE(compiled);
+        EXPECT_TRUE(reader.MoveToElement("b"));
+        EXPECT_EQ("22", reader.GetAttributeValueString("id"));
+    }
+    miso::StringUtils::WriteFile(filename, "<a><b id='33'/></a>");
+    {
+        auto reader = miso::BinaryXmlReader::Open(filename, cache_filename, miso::BinaryXmlValidation::Hash, &compiled);
+        EXPECT_TRUE(compiled);
+        EXPECT_TRUE(reader.MoveToElement("b"));
+        EXPECT_EQ("33", reader.GetAttributeValueString("id"));
+    }
+    {
+        auto reader = miso::BinaryXmlReader::Open(filename, cache_filename, miso::BinaryXmlValidation::Hash, &compiled);
+        EXPECT_FALSE(compiled);
+    }
+    std::remove(filename);
+    {
+        auto reader = miso::BinaryXmlReader::Open(filename, cache_filename, miso::BinaryXmlValidation::Hash, &compiled);
+        EXPECT_FALSE(compiled);
+        EXPECT_TRUE(reader.MoveToElement("b"));
+    }
+    std::remove(cache_filename);
+    {
+        auto reader = miso::BinaryXmlReader::Open(filename, cache_filename);
+        EXPECT_TRUE(reader.HasError());
+        EXPECT_FALSE(reader.Read());
+    }
+}
+
+TEST_F(MisoTest, XmlReader_Reset)
+{
+    TEST_TRACE("");
+    const char xml[] = "<a><b id='1'/></a>";
+    miso::XmlReader reader(xml, sizeof(xml) - 1);
+    auto atom = reader.Intern("b");
+    EXPECT_TRUE(reader.MoveToElement(atom));
+    for (auto filename : { "test.xml", "test2.xml" }) {
+        miso::XmlReader expected_reader(filename);
+        auto expected = DumpXmlNodes(expected_reader);
+        EXPECT_TRUE(reader.Reset(filename));
+        EXPECT_TRUE(reader.CanRead());
+        EXPECT_EQ(expected, DumpXmlNodes(reader));
+        auto content = miso::StringUtils::ReadFile(filename);
+        EXPECT_TRUE(reader.Reset(content.data(), content.size()));
+        EXPECT_EQ(expected, DumpXmlNodes(reader));
+    }
+    EXPECT_TRUE(reader.Reset(xml, sizeof(xml) - 1));
+    EXPECT_TRUE(reader.MoveToElement(atom));
+    EXPECT_EQ("1", reader.GetAttributeValueString("id"));
+
+    const char broken_xml[] = "<a><b></a>";
+    EXPECT_TRUE(reader.Reset(broken_xml, sizeof(broken_xml) - 1));
+    DumpXmlNodes(reader);
+    EXPECT_TRUE(reader.HasError());
+    EXPECT_TRUE(reader.Reset(xml, sizeof(xml) - 1));
+    EXPECT_FALSE(reader.HasError());
+    EXPECT_EQ("0 Start a\n1 Empty b id=1\n0 End a\n", DumpXmlNodes(reader));
+
+    EXPECT_FALSE(reader.Reset("test_error_file_not_found.xml"));
+    EXPECT_FALSE(reader.CanRead());
+    EXPECT_FALSE(reader.Read());
+    EXPECT_EQ("Cannot open file", reader.GetErrors()[0]);
+
+    miso::XmlReader missing_reader("test_error_file_not_found.xml");
+    EXPECT_TRUE(missing_reader.Reset(xml, sizeof(xml) - 1));
+    miso::XmlReader moved_reader(std::move(missing_reader));
+    EXPECT_EQ("0 Start a\n1 Empty b id=1\n0 End a\n", DumpXmlNodes(moved_reader));
+}
+
+TEST_F(MisoTest, XmlReaderPool)
+{
+    TEST_TRACE("");
+    auto& pool = miso::XmlReaderPool::GetForCurrentThread();
+    EXPECT_EQ(&pool, &miso::XmlReaderPool::GetForCurrentThread());
+    miso::XmlReader* first_reader;
+    {
+        auto reader = pool.Acquire("test2.xml");
+        first_reader = &*reader;
+        EXPECT_TRUE(reader->MoveToElement("element", "id", "element2"));
+    }
+    EXPECT_EQ(1, pool.GetIdleCount());
+    int count = 0;
+    for (int i = 0; i < 1000; i++) {
+        auto xml = miso::StringUtils::Format("<style color='#%06x' width='%dpx'/>", i, i);
+        auto reader = pool.Acquire(xml.data(), xml.size());
+        EXPECT_EQ(first_reader, &*reader);
+        if (reader->Read() && reader->GetAttributeValueString("width") == std::to_string(i) + "px") count++;
+    }
+    EXPECT_EQ(1000, count);
+    {
+        auto reader1 = pool.Acquire("test2.xml");
+        auto reader2 = pool.Acquire("test2.xml");
+        EXPECT_EQ(0, pool.GetIdleCount());
+        EXPECT_EQ(DumpXmlNodes(*reader1), DumpXmlNodes(*reader2));
+    }
+    EXPECT_EQ(2, pool.GetIdleCount());
+
+    miso::XmlReaderPool small_pool(1);
+    {
+        auto reader1 = small_pool.Acquire("test2.xml");
+        auto reader2 = std::move(reader1);
+        auto reader3 = small_pool.Acquire("test2.xml");
+    }
+    EXPECT_EQ(1, small_pool.GetIdleCount());
+}
+
+TEST_F(MisoTest, XmlReader_Stream)
+{
+    TEST_TRACE("");
+    for (auto filename : { "test.xml", "test2.xml" }) {
+        miso::XmlReader expected_reader(filename);
+        auto expected = DumpXmlNodes(expected_reader);
+        {
+            miso::FileStream stream(filename);
+            miso::XmlReader reader(stream);
+            EXPECT_EQ(expected, DumpXmlNodes(reader));
+            EXPECT_FALSE(reader.HasError());
+        }
+        {
+            auto content = miso::StringUtils::ReadFile(filename);
+            miso::MemoryStream stream(reinterpret_cast<const uint8_t*>(content.data()), content.size());
+            miso::XmlReader reader(stream);
+            EXPECT_EQ(expected, DumpXmlNodes(reader));
+            stream.SetPosition(0);
+            EXPECT_TRUE(reader.Reset(stream));
+            EXPECT_EQ(expected, DumpXmlNodes(reader));
+            stream.SetPosition(0);
+            auto pooled_reader = miso::XmlReaderPool::GetForCurrentThread().Acquire(stream);
+            EXPECT_EQ(expected, DumpXmlNodes(*pooled_reader));
+        }
+    }
+    {
+        const char xml[] = "<a><b></a>";
+        miso::MemoryStream stream(reinterpret_cast<const uint8_t*>(xml), sizeof(xml) - 1);
+        miso::XmlReader reader(stream);
+        DumpXmlNodes(reader);
+        EXPECT_TRUE(reader.HasError());
+    }
+}
+
+static std::string
+FeedXml(const std::string& xml, size_t chunk_size)
+{
+    static const char* types[] = { "None", "Start", "Empty", "End", "Text" };
+    miso::XmlFeedReader reader;
+    std::string dump;
+    size_t offset = 0;
+    while (true) {
+        auto result = reader.Read();
+        if (result == miso::XmlReadResult::End) break;
+        if (result == miso::XmlReadResult::NeedMoreData) {
+            if (offset < xml.size()) {
+                auto size = std::min(chunk_size, xml.size() - offset);
+                reader.Feed(xml.data() + offset, size);
+                offset += size;
+            } else {
+                reader.FinishFeeding();
+            }
+            continue;
+        }
+        dump += miso::StringUtils::Format("%d %s ", reader.GetNestingLevel(), types[static_cast<int>(reader.GetNodeType())]);
+        if (reader.GetNodeType() == miso::XmlNodeType::Text) {
+            dump += reader.GetContentText();
+        } else {
+            dump += reader.GetElementName();
+        }
+        for (auto& attribute : reader.GetAllAttributes()) {
+            dump += " " + attribute.GetName() + "=" + attribute.GetValue();
+        }
+        dump += "\n";
+    }
+    if (reader.HasError()) dump += reader.GetErrors()[0];
+    return dump;
+}
+
+TEST_F(MisoTest, XmlFeedReader)
+{
+    TEST_TRACE("");
+    {
+        auto xml = miso::StringUtils::ReadFile("test2.xml");
+        miso::XmlReader reader("test2.xml");
+        auto expected = DumpXmlNodes(reader);
+        for (size_t chunk_size : { 1, 7, 100, 65536 }) {
+            EXPECT_EQ(expected, FeedXml(xml, chunk_size));
+        }
+    }
+    {
+        std::string xml = "<a x='&amp;'>1&lt;2<!-- c -->3<![CDATA[<4>]]><b></b><c> </c></a>";
+        EXPECT_EQ("0 Start a x=&\n1 Text 1<23<4>\n1 Empty b\n1 Empty c\n0 End a\n", FeedXml(xml, 1));
+        EXPECT_EQ("0 Start a\n1 Start b\n[ERROR] Opening and ending tag mismatch: b line 1 and a", FeedXml("<a><b></a>", 3));
+    }
+    {
+        miso::XmlFeedReader reader;
+        EXPECT_EQ(miso::XmlReadResult::NeedMoreData, reader.Read());
+        EXPECT_TRUE(reader.Feed("<a><b id='1'", 12));
+        EXPECT_EQ(miso::XmlReadResult::NeedMoreData, reader.Read());
+        EXPECT_TRUE(reader.Feed("/>", 2));
+        EXPECT_EQ(miso::XmlReadResult::Node, reader.Read());
+        EXPECT_EQ("a", reader.GetElementName());
+        EXPECT_EQ(miso::XmlReadResult::Node, reader.Read());
+        EXPECT_EQ(miso::XmlNodeType::EmptyElement, reader.GetNodeType());
+        EXPECT_EQ("1", reader.GetAttributeValueString("id"));
+        EXPECT_EQ(nullptr, reader.GetAttributeValueView("name").data());
+        EXPECT_EQ(miso::XmlReadResult::NeedMoreData, reader.Read());
+        EXPECT_TRUE(reader.Feed("</a>", 4));
+        EXPECT_EQ(miso::XmlReadResult::Node, reader.Read());
+        EXPECT_EQ(miso::XmlNodeType::EndElement, reader.GetNodeType());
+        EXPECT_EQ(miso::XmlReadResult::NeedMoreData, reader.Read());
+        reader.FinishFeeding();
+        EXPECT_EQ(miso::XmlReadResult::End, reader.Read());
+        EXPECT_FALSE(reader.HasError());
+        EXPECT_FALSE(reader.Feed("<a/>", 4));
+    }
+    {
+        // A warning does not stop reading.
+        miso::XmlFeedReader reader;
+        EXPECT_TRUE(reader.Feed("<a xmlns='rel'><b/>", 19));
+        EXPECT_TRUE(reader.HasError());
+        EXPECT_EQ(miso::XmlReadResult::Node, reader.Read());
+        EXPECT_EQ("a", reader.GetElementName());
+        EXPECT_EQ(miso::XmlReadResult::Node, reader.Read());
+        EXPECT_EQ("b", reader.GetElementName());
+        EXPECT_EQ(miso::XmlReadResult::NeedMoreData, reader.Read());
+        EXPECT_TRUE(reader.Feed("<c/></a>", 8));
+        EXPECT_EQ(miso::XmlReadResult::Node, reader.Read());
+        EXPECT_EQ("c", reader.GetElementName());
+        EXPECT_EQ(miso::XmlReadResult::Node, reader.Read());
+        EXPECT_EQ(miso::XmlNodeType::EndElement, reader.GetNodeType());
+        reader.FinishFeeding();
+        EXPECT_EQ(miso::XmlReadResult::End, reader.Read());
+        EXPECT_EQ(1, reader.GetErrors().size());
+    }
+}
+
+TEST_F(MisoTest, PrefetchFileStream)
+{
+    TEST_TRACE("");
+    miso::FileStream file_stream("test2.xml");
+    std::vector<uint8_t> expected(file_stream.GetSize());
+    ASSERT_EQ(expected.size(), file_stream.ReadBlock(expected.data(), expected.size()));
+    ASSERT_LT(200, expected.size());
+
+    miso::PrefetchFileStream stream("test2.xml", 64, 2);
+    EXPECT_EQ(expected.size(), stream.GetSize());
+    EXPECT_TRUE(stream.CanRead(expected.size()));
+    EXPECT_FALSE(stream.CanRead(expected.size() + 1));
+    EXPECT_EQ(expected[0], stream.Peek());
+    EXPECT_EQ(expected[0], stream.Read());
+    std::vector<uint8_t> data(expected.size());
+    data[0] = expected[0];
+    EXPECT_EQ(expected.size() - 1, stream.ReadBlock(data.data() + 1, data.size()));
+    EXPECT_EQ(expected, data);
+    EXPECT_FALSE(stream.CanRead());
+    EXPECT_EQ(0, stream.ReadBlock(data.data(), data.size()));
+
+    stream.SetPosition(100);
+    EXPECT_EQ(100, stream.GetPosition());
+    EXPECT_EQ(expected[100], stream.Read());
+    stream.SetPosition(120);
+    EXPECT_EQ(expected[120], stream.Read());
+    stream.SetPosition(10);
+    EXPECT_EQ(expected[10], stream.Read());
+    EXPECT_EQ(11, stream.GetPosition());
+
+    for (size_t chunk_size : { 1, 100, 1 << 20 }) {
+        miso::XmlReader expected_reader("test2.xml");
+        miso::PrefetchFileStream xml_stream("test2.xml", chunk_size, 4);
+        miso::XmlReader reader(xml_stream);
+        EXPECT_EQ(DumpXmlNodes(expected_reader), DumpXmlNodes(reader));
+    }
+    {
+        miso::PrefetchFileStream unread_stream("test2.xml", 16, 2);
+    }
+    miso::PrefetchFileStream missing_stream("test_error_file_not_found.xml");
+    EXPECT_FALSE(missing_stream.CanRead());
+    EXPECT_EQ(0, missing_stream.ReadBlock(data.data(), data.size()));
+}
+
+class TestBatchVisitor : public miso::IXmlBatchVisitor {
+public:
+    explicit TestBatchVisitor(size_t count) : dumps(count) {}
+
+    void OnDocument(size_t index, miso::XmlReader& reader) override { dumps[index] = DumpXmlNodes(reader); }
+
+    std::vector<std::string> dumps;
+};
+
+TEST_F(MisoTest, XmlBatch)
+{
+    TEST_TRACE("");
+    std::vector<std::string> xmls;
+    for (int i = 0; i < 200; i++) {
+        xmls.push_back(miso::StringUtils::Format("<layout id='%d'><view width='%dpx'/></layout>", i, i));
+    }
+    const char broken_xml[] = "<a><b></a>";
+    miso::XmlBatch batch;
+    for (auto& xml : xmls) {
+        batch.AddBuffer(xml.data(), xml.size());
+        batch.AddFile("test2.xml");
+    }
+    batch.AddFile("test_error_file_not_found.xml");
+    batch.AddBuffer(broken_xml, sizeof(broken_xml) - 1);
+    ASSERT_EQ(402, batch.GetCount());
+
+    miso::XmlReader test2_reader("test2.xml");
+    auto test2_dump = DumpXmlNodes(test2_reader);
+    for (size_t thread_count : { 1, 4, 0 }) {
+        TestBatchVisitor visitor(batch.GetCount());
+        EXPECT_FALSE(batch.Run(visitor, thread_count));
+        for (size_t i = 0; i < xmls.size(); i++) {
+            EXPECT_EQ(miso::StringUtils::Format("0 Start layout id=%d\n1 Empty view width=%dpx\n0 End layout\n", i, i), visitor.dumps[i * 2]);
+            EXPECT_EQ(test2_dump, visitor.dumps[i * 2 + 1]);
+            EXPECT_TRUE(batch.GetErrors(i * 2).empty());
+        }
+        EXPECT_EQ("", visitor.dumps[400]);
+        EXPECT_EQ("Cannot open file", batch.GetErrors(400)[0]);
+        EXPECT_FALSE(batch.GetErrors(401).empty());
+    }
+}
+
+static std::string
+StripRootNodes(const std::string& dump)
+{
+    auto begin = dump.find('\n') + 1;
+    auto end = dump.rfind('\n', dump.size() - 2) + 1;
+    return (begin < end) ? dump.substr(begin, end - begin) : std::string();
+}
+
+class TestContentSink : public miso::IXmlContentSink {
+public:
+    bool OnContentChunk(std::string_view chunk) override
+    {
+        chunks.emplace_back(chunk);
+        return chunks.size() < max_count;
+    }
+
+    std::vector<std::string> chunks;
+    size_t max_count = SIZE_MAX;
+};
+
+TEST_F(MisoTest, XmlReader_ReadContentChunks)
+{
+    TEST_TRACE("");
+    std::string payload;
+    for (int i = 0; i < 100000; i++) {
+        payload += static_cast<char>('A' + i % 26);
+    }
+    auto xml = "<root><data>" + payload + "</data><text>\xE3\x81\x82\xE3\x81\x84<![CDATA[\xE3\x81\x86]]></text></root>";
+    {
+        miso::XmlReader reader(xml.data(), xml.size());
+        TestContentSink sink;
+        EXPECT_TRUE(reader.MoveToElement("data"));
+        EXPECT_FALSE(reader.ReadContentChunks(sink));
+        EXPECT_TRUE(reader.Read());
+        EXPECT_TRUE(reader.ReadContentChunks(sink, 30000));
+        ASSERT_EQ(4, sink.chunks.size());
+        EXPECT_EQ(30000, sink.chunks[0].size());
+        EXPECT_EQ(10000, sink.chunks[3].size());
+        EXPECT_EQ(payload, sink.chunks[0] + sink.chunks[1] + sink.chunks[2] + sink.chunks[3]);
+
+        TestContentSink stopped_sink;
+        stopped_sink.max_count = 2;
+        EXPECT_FALSE(reader.ReadContentChunks(stopped_sink, 1000));
+        EXPECT_EQ(2, stopped_sink.chunks.size());
+
+        // Split between the characters
+        TestContentSink utf8_sink;
+        EXPECT_TRUE(reader.MoveToElement("text"));
+        EXPECT_TRUE(reader.Read());
+        EXPECT_TRUE(reader.ReadContentChunks(utf8_sink, 4));
+        ASSERT_EQ(2, utf8_sink.chunks.size());
+        EXPECT_EQ("\xE3\x81\x82", utf8_sink.chunks[0]);
+        EXPECT_EQ("\xE3\x81\x84", utf8_sink.chunks[1]);
+        TestContentSink small_sink;
+        EXPECT_TRUE(reader.ReadContentChunks(small_sink, 2));
+        ASSERT_EQ(4, small_sink.chunks.size());
+        EXPECT_EQ("\xE3\x81", small_sink.chunks[0]);
+        EXPECT_EQ("\x82", small_sink.chunks[1]);
+    }
+    {
+        miso::XmlReaderOptions options;
+        options.coalesce_text = true;
+        miso::XmlReader reader(xml.data(), xml.size(), options);
+        TestContentSink sink;
+        EXPECT_TRUE(reader.MoveToElement("text"));
+        EXPECT_TRUE(reader.Read());
+        EXPECT_TRUE(reader.ReadContentChunks(sink, 7));
+        ASSERT_EQ(2, sink.chunks.size());
+        EXPECT_EQ("\xE3\x81\x82\xE3\x81\x84", sink.chunks[0]);
+        EXPECT_EQ("\xE3\x81\x86", sink.chunks[1]);
+    }
+}
+
+TEST_F(MisoTest, XmlReader_AttributeValue)
+{
+    TEST_TRACE("");
+    const char xml[] =
+        "<root>"
+        "<view width='12px' color='#ff0000' margin=' 1px 2px ' name='view' on='true' ref='1&amp;2'/>"
+        "<view width='12px' color='rgb(0, 0, 255)' margin='3px' name='#00ff00'/>"
+        "</root>";
+    for (bool cache : { false, true }) {
+        miso::XmlReaderOptions options;
+        options.cache_attribute_values = cache;
+        miso::XmlReader reader(xml, sizeof(xml) - 1, options);
+        EXPECT_FALSE(reader.GetAttributeValue("width").IsValid());
+        ASSERT_TRUE(reader.MoveToElement("view"));
+        {
+            auto width = reader.GetAttributeNumeric("width");
+            EXPECT_EQ(12.0, width.GetValue());
+            EXPECT_EQ(miso::NumericUnit::Pixel, width.GetUnit());
+            EXPECT_EQ(miso::Color(0xff0000ff), reader.GetAttributeColor("color"));
+            EXPECT_EQ(1.0, reader.GetAttributeNumeric("on").GetValue());
+
+            auto margin = reader.GetAttributeValue("margin");
+            ASSERT_EQ(2, margin.GetCount());
+            EXPECT_EQ(2.0, margin.AsNumeric(1).GetValue());
+            EXPECT_FALSE(reader.GetAttributeNumeric("margin").IsValid());
+
+            EXPECT_FALSE(reader.GetAttributeValue("name").IsValid());
+            EXPECT_FALSE(reader.GetAttributeNumeric("color").IsValid());
+            EXPECT_FALSE(reader.GetAttributeColor("width").IsValid());
+            EXPECT_FALSE(reader.GetAttributeValue("ref").IsValid());
+            EXPECT_FALSE(reader.GetAttributeNumeric("none").IsValid());
+            EXPECT_FALSE(reader.GetAttributeColor("none").IsValid());
+        }
+        ASSERT_TRUE(reader.MoveToElement("view"));
+        {
+            EXPECT_EQ(12.0, reader.GetAttributeNumeric("width").GetValue());
+            EXPECT_EQ(miso::Color(0x0000ffff), reader.GetAttributeColor("color"));
+            EXPECT_EQ(3.0, reader.GetAttributeValue("margin").AsNumeric().GetValue());
+            EXPECT_EQ(miso::Color(0x00ff00ff), reader.GetAttributeColor("name"));
+        }
+        EXPECT_TRUE(reader.Reset(xml, sizeof(xml) - 1));
+        ASSERT_TRUE(reader.MoveToElement("view"));
+        EXPECT_EQ(12.0, reader.GetAttributeNumeric("width").GetValue());
+    }
+    {
+        // Values beyond the capacity of the cache are parsed each time
+        std::string many_xml = "<root>";
+        for (int i = 0; i < 5000; i++) {
+            many_xml += miso::StringUtils::Format("<view width='%dpx'/>", i);
+        }
+        many_xml += "</root>";
+        miso::XmlReaderOptions options;
+        options.cache_attribute_values = true;
+        miso::XmlReader reader(many_xml.data(), many_xml.size(), options);
+        int count = 0;
+        while (reader.MoveToElement("view")) {
+            if (reader.GetAttributeNumeric("width").GetValue() == count) ++count;
+        }
+        EXPECT_EQ(5000, count);
+    }
+}
+
+TEST_F(MisoTest, XmlReader_Options)
+{
+    TEST_TRACE("");
+    const char xml[] = "<a>1<!-- c -->2<![CDATA[<3>]]>4&amp;<b/>\n  <![CDATA[ ]]>\n  <c>5</c><d> <e/> </d>6</a>";
+    {
+        miso::XmlReader reader(xml, sizeof(xml) - 1);
+        EXPECT_EQ("0 Start a\n1 Text 1\n1 Text 2\n1 Text 4&\n1 Empty b\n1 Start c\n2 Text 5\n1 End c\n1 Start d\n2 Empty e\n1 End d\n1 Text 6\n0 End a\n", DumpXmlNodes(reader));
+    }
+    {
+        miso::XmlReaderOptions options;
+        options.no_cdata = true;
+        options.no_blanks = true;
+        options.compact = true;
+        options.huge = true;
+        miso::XmlReader reader(xml, sizeof(xml) - 1, options);
+        EXPECT_EQ("0 Start a\n1 Text 1\n1 Text 2<3>4&\n1 Empty b\n1 Start c\n2 Text 5\n1 End c\n1 Start d\n2 Empty e\n1 End d\n1 Text 6\n0 End a\n", DumpXmlNodes(reader));
+        EXPECT_FALSE(reader.HasError());
+    }
+    {
+        miso::XmlReaderOptions options;
+        options.coalesce_text = true;
+        miso::XmlReader reader(xml, sizeof(xml) - 1, options);
+        EXPECT_EQ("0 Start a\n1 Text 1\n1 Text 2<3>4&\n1 Empty b\n1 Start c\n2 Text 5\n1 End c\n1 Start d\n2 Empty e\n1 End d\n1 Text 6\n0 End a\n", DumpXmlNodes(reader));
+
+        // The options are kept over Reset().
+        ASSERT_TRUE(reader.Reset(xml, sizeof(xml) - 1));
+        ASSERT_TRUE(reader.MoveToElement("a"));
+        ASSERT_TRUE(reader.Read());
+        ASSERT_TRUE(reader.Read());
+        EXPECT_EQ(miso::XmlNodeType::Text, reader.GetNodeType());
+        EXPECT_EQ("2<3>4&", reader.GetContentText());
+        EXPECT_EQ(1, reader.GetNestingLevel());
+        EXPECT_EQ("", reader.GetAttributeValueString("x"));
+        EXPECT_TRUE(reader.MoveToElement());
+        EXPECT_EQ("b", reader.GetElementName());
+        EXPECT_TRUE(reader.MoveToElement("d"));
+        ASSERT_TRUE(reader.Read());
+        ASSERT_TRUE(reader.Read());
+        EXPECT_EQ(miso::XmlNodeType::EndElement, reader.GetNodeType());
+        EXPECT_EQ("d", reader.GetElementName());
+        ASSERT_TRUE(reader.Read());
+        EXPECT_EQ("6", reader.GetContentText());
+        EXPECT_TRUE(reader.MoveToEndOfParentElement());
+        EXPECT_EQ("a", reader.GetElementName());
+        EXPECT_EQ(0, reader.GetNestingLevel());
+    }
+    {
+        miso::XmlReader reader("test.xml");
+        miso::XmlReaderOptions options;
+        options.no_blanks = true;
+        options.coalesce_text = true;
+        miso::XmlReader options_reader("test.xml", options);
+        EXPECT_EQ(DumpXmlNodes(reader), DumpXmlNodes(options_reader));
+    }
+}
+
+TEST_F(MisoTest, XmlReader_CaptureSubtree)
+{
+    TEST_TRACE("");
+    std::string xml = "<?xml version='1.0'?>\n<!DOCTYPE doc [ <!ENTITY e \"E\"> ]>\n"
+        "<doc xmlns='urn:d' xmlns:y='urn:outer'><head><title>t</title></head><body xmlns:y='urn:y'>";
+    for (int i = 0; i < 60; i++) {
+        xml += miso::StringUtils::Format("<section id='s%d'><!-- <section> --><y:p>p&e;%d</y:p><![CDATA[<x>]]><empty/></section>", i, i);
+    }
+    xml += "</body></doc>";
+
+    // Skeleton pass with the sections captured, skipped and walked through
+    miso::XmlReaderOptions options;
+    options.capture_subtrees = true;
+    miso::XmlReader reader(xml.data(), xml.size(), options);
+    ASSERT_TRUE(reader.MoveToElement("head"));
+    ASSERT_TRUE(reader.SkipSubtree());
+    ASSERT_EQ("body", reader.GetElementName());
+    ASSERT_TRUE(reader.Read());
+    std::vector<miso::XmlSubtree> subtrees;
+    for (int i = 0; i < 60; i++) {
+        ASSERT_EQ(miso::StringUtils::Format("s%d", i), reader.GetAttributeValueString("id"));
+        if (i % 3 == 0) {
+            subtrees.push_back(reader.CaptureSubtree());
+            ASSERT_FALSE(subtrees.back().IsNull());
+        } else if (i % 3 == 1) {
+            ASSERT_TRUE(reader.SkipSubtree());
+        } else {
+            ASSERT_TRUE(reader.MoveToEndElement());
+            ASSERT_TRUE(reader.Read());
+        }
+    }
+    EXPECT_EQ(miso::XmlNodeType::EndElement, reader.GetNodeType());
+    EXPECT_EQ("body", reader.GetElementName());
+    EXPECT_FALSE(reader.HasError());
+    EXPECT_EQ("<section id='s3'><!-- <section> --><y:p>p&e;3</y:p><![CDATA[<x>]]><empty/></section>", subtrees[1].GetSource());
+
+    // The subtrees are read on other threads.
+    std::vector<std::string> dumps(subtrees.size());
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            for (auto i = t; i < subtrees.size(); i += 4) {
+                miso::XmlReader subtree_reader(subtrees[i]);
+                dumps[i] = miso::StringUtils::Format("%d %s\n", subtree_reader.GetNestingLevel(), subtree_reader.GetAttributeValueString("id").c_str());
+                dumps[i] += DumpXmlNodes(subtree_reader);
+                if (subtree_reader.HasError()) dumps[i] += subtree_reader.GetErrors()[0];
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    for (size_t i = 0; i < subtrees.size(); i++) {
+        EXPECT_EQ(miso::StringUtils::Format("1 s%d\n2 Start y:p\n3 Text p\n3 Text %d\n2 End y:p\n2 Empty empty\n1 End section\n0 End body\n", i * 3, i * 3), dumps[i]);
+    }
+
+    // The root
+    miso::XmlReader root_reader(xml.data(), xml.size(), options);
+    ASSERT_TRUE(root_reader.Read());
+    auto root = root_reader.CaptureSubtree();
+    EXPECT_FALSE(root_reader.Read());
+    miso::XmlReader whole_reader(root);
+    EXPECT_EQ(0, whole_reader.GetNestingLevel());
+    EXPECT_TRUE(whole_reader.MoveToElement("section", "id", "s59"));
+    EXPECT_FALSE(whole_reader.HasError());
+
+    // A reader of a file, or of a buffer without the option, cannot capture.
+    miso::XmlReader file_reader("test2.xml", options);
+    ASSERT_TRUE(file_reader.Read());
+    EXPECT_TRUE(file_reader.CaptureSubtree().IsNull());
+    EXPECT_EQ(miso::XmlNodeType::StartElement, file_reader.GetNodeType());
+    miso::XmlReader plain_reader(xml.data(), xml.size());
+    ASSERT_TRUE(plain_reader.MoveToElement("body"));
+    EXPECT_TRUE(plain_reader.CaptureSubtree().IsNull());
+    EXPECT_EQ("body", plain_reader.GetElementName());
+    EXPECT_TRUE(plain_reader.Reset(xml.data(), xml.size()));
+    ASSERT_TRUE(plain_reader.Read());
+    EXPECT_TRUE(plain_reader.CaptureSubtree().IsNull());
+}
+
+TEST_F(MisoTest, XmlElementIndex)
+{
+    TEST_TRACE("");
+    std::string xml = "<?xml version='1.0'?>\n<!DOCTYPE root [ <!ENTITY e \"E\"> ]>\n<root xmlns:x='urn:x' id='top'>";
+    for (int i = 0; i < 100; i++) {
+        xml += miso::StringUtils::Format("<group id='g%d'><!-- <element id='c%d'/> --><element name='n&e;' id = \"e%d\"><x:tag/></element><element/></group>", i, i, i);
+    }
+    xml += "</root>\n";
+
+    miso::XmlElementIndex index;
+    ASSERT_TRUE(index.Build(xml.data(), xml.size()));
+    EXPECT_EQ(1 + 100 * 4, index.GetCount());
+    EXPECT_EQ(0, index.Find("top"));
+    EXPECT_EQ(miso::XmlElementIndex::kNotFound, index.Find("c5"));
+    auto& entry = index.GetEntry(index.Find("e42"));
+    EXPECT_EQ(2, entry.depth);
+    EXPECT_EQ("<element name='n&e;' id = \"e42\"><x:tag/></element>", xml.substr(entry.begin, entry.end - entry.begin));
+
+    miso::XmlReader reader("test2.xml");
+    ASSERT_TRUE(reader.SeekToElement(index, "e42"));
+    EXPECT_EQ(1, reader.GetNestingLevel());
+    EXPECT_EQ("e42", entry.key);
+    EXPECT_EQ("nE", reader.GetAttributeValueString("name"));
+    EXPECT_EQ("2 Empty x:tag\n1 End element\n0 End root\n", DumpXmlNodes(reader));
+    EXPECT_FALSE(reader.HasError());
+
+    ASSERT_TRUE(reader.SeekToElement(index, "g99"));
+    EXPECT_EQ("g99", reader.GetAttributeValueString("id"));
+    EXPECT_TRUE(reader.MoveToElement("x:tag"));
+    ASSERT_TRUE(reader.SeekToElement(index, "top"));
+    EXPECT_EQ(0, reader.GetNestingLevel());
+    EXPECT_EQ("root", reader.GetElementName());
+    EXPECT_TRUE(reader.MoveToElement("element", "id", "e99"));
+    EXPECT_FALSE(reader.SeekToElement(index, "missing"));
+
+    miso::XmlElementIndex depth_index;
+    ASSERT_TRUE(depth_index.Build(xml.data(), xml.size(), "id", 1));
+    EXPECT_EQ(101, depth_index.GetCount());
+    EXPECT_EQ(miso::XmlElementIndex::kNotFound, depth_index.Find("e42"));
+
+    // The prefix p is declared only by an ancestor between the root and the element.
+    std::string scoped_xml = "<root xmlns:x='urn:x' xml:lang='en' id='r'><outer xmlns:p='urn:p' xml:lang='fr'>"
+        "<inner xmlns:x='urn:y' xml:space='preserve'><p:item id='deep' x:name='n'><p:child/></p:item></inner></outer></root>";
+    miso::XmlElementIndex scoped_index;
+    ASSERT_TRUE(scoped_index.Build(scoped_xml.data(), scoped_xml.size()));
+    auto deep_index = scoped_index.Find("deep");
+    EXPECT_EQ(2, scoped_index.GetEntry(deep_index).parent);
+    EXPECT_EQ(miso::XmlElementIndex::kNotFound, scoped_index.GetEntry(0).parent);
+    EXPECT_EQ("<root id='r' xmlns:x='urn:y' xml:space='preserve' xmlns:p='urn:p' xml:lang='fr'>",
+        scoped_index.MakeScopePrefix(deep_index));
+    ASSERT_TRUE(reader.SeekToElement(scoped_index, "deep"));
+    EXPECT_EQ("p:item", reader.GetElementName());
+    EXPECT_EQ("n", reader.GetAttributeValueString("x:name"));
+    EXPECT_EQ("2 Empty p:child\n1 End p:item\n0 End root\n", DumpXmlNodes(reader));
+    EXPECT_FALSE(reader.HasError());
+
+    miso::XmlElementScanner scanner(scoped_xml.data(), scoped_xml.size());
+    ASSERT_TRUE(scanner.Next());
+    EXPECT_EQ(0, scanner.GetRootBegin());
+    ASSERT_TRUE(scanner.Next());
+    ASSERT_TRUE(scanner.Next());
+    EXPECT_EQ(2, scanner.GetDepth());
+    EXPECT_EQ(scoped_xml.find("<inner"), scanner.GetBegin());
+    ASSERT_TRUE(scanner.Next());
+    EXPECT_EQ(3, scanner.GetDepth());
+    EXPECT_TRUE(scanner.SkipElement());
+    EXPECT_EQ(scoped_xml.find("</inner>"), scanner.GetPosition());
+    EXPECT_FALSE(scanner.Next());
+
+    const char broken_xml[] = "<a><b></a>";
+    EXPECT_FALSE(index.Build(broken_xml, sizeof(broken_xml) - 1));
+    EXPECT_EQ(0, index.GetCount());
+}
+
+TEST_F(MisoTest, XmlSplitParser)
+{
+    TEST_TRACE("");
+    std::string xml = "<?xml version='1.0'?>\n<!DOCTYPE root [ <!ENTITY e \"E\"> ]>\n<!-- <header> -->\n<root a='>' b=\"/>\">";
+    for (int i = 0; i < 500; i++) {
+        xml += miso::StringUtils::Format("<item id='%d'><!-- </item> --><name>n&e;</name><?pi </item>?></item>text<empty/>", i);
+    }
+    xml += "</root>\n";
+    miso::XmlReader reader(xml.data(), xml.size());
+    auto expected = StripRootNodes(DumpXmlNodes(reader));
+
+    for (size_t thread_count : { 1, 4 }) {
+        miso::XmlSplitParser parser(xml.data(), xml.size());
+        EXPECT_TRUE(parser.Split(thread_count * 4));
+        EXPECT_EQ(thread_count * 4, parser.GetPartCount());
+        TestBatchVisitor visitor(parser.GetPartCount());
+        EXPECT_TRUE(parser.Run(visitor, thread_count));
+        EXPECT_FALSE(parser.HasError());
+        std::string merged;
+        for (auto& dump : visitor.dumps) {
+            EXPECT_EQ(0, dump.find("0 Start root a=> b=/>\n"));
+            merged += StripRootNodes(dump);
+        }
+        EXPECT_EQ(expected, merged);
+    }
+
+    // Read as one part
+    const char broken_xml[] = "<a><b></a>";
+    miso::XmlSplitParser broken_parser(broken_xml, sizeof(broken_xml) - 1);
+    TestBatchVisitor visitor(1);
+    EXPECT_FALSE(broken_parser.Run(visitor, 2));
+    EXPECT_EQ(1, broken_parser.GetPartCount());
+    EXPECT_TRUE(broken_parser.HasError());
+    EXPECT_FALSE(broken_parser.GetErrors(0).empty());
+}
+
+// Counts the names reported with the pointers of the dictionary.
+class TestDictionaryHandler : public miso::IXmlSaxHandler {
+public:
+    explicit TestDictionaryHandler(const miso::XmlDictionary& dictionary) :
+        element_name_(dictionary.Find("member")),
+        attribute_name_(dictionary.Find("name"))
+    {}
+
+    void OnStartElement(std::string_view name, miso::ArrayView<miso::XmlSaxAttribute> attributes) override
+    {
+        if (name == element_name_) ++name_count;
+        if (name.data() == element_name_.data()) ++shared_name_count;
+        for (auto& attribute : attributes) {
+            if (attribute.name.data() == attribute_name_.data()) ++shared_name_count;
+        }
+    }
+
+    int name_count = 0;
+    int shared_name_count = 0;
+
+private:
+    std::string_view element_name_;
+    std::string_view attribute_name_;
+};
+
+TEST_F(MisoTest, XmlDictionary)
+{
+    TEST_TRACE("");
+    miso::XmlDictionary dictionary{ "member", "name" };
+    EXPECT_EQ("member", dictionary.Find("member"));
+    EXPECT_EQ(nullptr, dictionary.Find("summary").data());
+
+    // Parsers on several threads, each reused for another document
+    auto xml = MakeMembersXml(100);
+    std::vector<std::unique_ptr<TestDictionaryHandler>> handlers;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        handlers.push_back(std::make_unique<TestDictionaryHandler>(dictionary));
+        threads.emplace_back([&xml, &dictionary, &handler = *handlers.back()] {
+            miso::XmlSaxParser parser(handler);
+            parser.SetDictionary(&dictionary);
+            for (int i = 0; i < 2; i++) {
+                EXPECT_TRUE(parser.Parse(xml.data(), xml.size()));
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    for (auto& handler : handlers) {
+        EXPECT_EQ(200, handler->name_count);
+        EXPECT_EQ(600, handler->shared_name_count);
+    }
+
+    // Without the dictionary, the names are of the parser.
+    TestDictionaryHandler handler(dictionary);
+    miso::XmlSaxParser parser(handler);
+    EXPECT_TRUE(parser.Parse(xml.data(), xml.size()));
+    EXPECT_EQ(100, handler.name_count);
+    EXPECT_EQ(0, handler.shared_name_count);
+}
+
 TEST_F(MisoTest, XmlReader_ErrorAttributeDupulicated)
 {
     TEST_TRACE("");
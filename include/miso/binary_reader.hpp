@@ -18,6 +18,8 @@ public:
     BinaryReader& operator=(BinaryReader&&) = delete;
     explicit BinaryReader(const char* filename, Endian endian = Endian::Native);
     explicit BinaryReader(const uint8_t* buffer, size_t size, Endian endian = Endian::Native);
+    // The stream is not owned by BinaryReader and must outlive it.
+    explicit BinaryReader(IStream& stream, Endian endian = Endian::Native);
     ~BinaryReader();
 
     bool CanRead(size_t size = 1) const { return stream_ != nullptr && stream_->CanRead(size); }
@@ -26,17 +28,19 @@ public:
     void SetEndian(Endian endian) { target_endian_ = endian; }
     size_t GetPosition() const { return stream_->GetPosition(); }
     void SetPosition(size_t position) { stream_->SetPosition(position); }
+    const StreamStats& GetStats() const { return (stream_ != nullptr) ? stream_->GetStats() : StreamStats::GetEmpty(); }
     template<typename T> T Read(T default_value = 0) { return ReadStream(default_value, true); }
     template<typename T> T Peek(T default_value = 0) { return ReadStream(default_value, false); }
     template<typename TAllocator = std::allocator<uint8_t>> Buffer<TAllocator> ReadBlock(size_t size);
     size_t ReadBlock(void* buffer_out, size_t size);
 
 private:
-    BinaryReader(IStream* stream, Endian endian = Endian::Native);
+    BinaryReader(IStream* stream, Endian endian, bool owns_stream);
 
     template<typename T> T ReadStream(T default_value, bool advance);
 
     IStream* stream_ = nullptr;
+    bool owns_stream_ = true;
     Endian native_endian_ = Endian::Native;
     Endian target_endian_ = Endian::Native;
 };
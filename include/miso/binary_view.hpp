@@ -0,0 +1,202 @@
+#ifndef MISO_BINARY_VIEW_HPP_
+#define MISO_BINARY_VIEW_HPP_
+
+#include "miso/common.hpp"
+
+#include <cstring>
+#include <type_traits>
+
+#include "miso/endian_utils.hpp"
+#include "miso/memory_stream.hpp"
+
+namespace miso {
+
+// Value stored in the given byte order.
+// It has no alignment requirement and converts on access, so it can be overlaid directly on file data.
+template<typename T, Endian kEndian>
+class EndianValue {
+public:
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "EndianValue requires an arithmetic or enum type");
+    static_assert(sizeof(T) <= sizeof(uint64_t), "EndianValue supports types up to 8 bytes");
+
+    EndianValue() = default;
+    EndianValue(T value) { Set(value); }
+
+    operator T() const { return Get(); }
+    T Get() const;
+    void Set(T value);
+
+private:
+    using Bits =
+        typename std::conditional<sizeof(T) == 1, uint8_t,
+        typename std::conditional<sizeof(T) == 2, uint16_t,
+        typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type>::type>::type;
+
+    static bool NeedsFlip() { return kEndian != Endian::Native && kEndian != EndianUtils::GetNativeEndian(); }
+
+    uint8_t bytes_[sizeof(T)] = {};
+};
+
+template<typename T> using LittleEndian = EndianValue<T, Endian::Little>;
+template<typename T> using BigEndian = EndianValue<T, Endian::Big>;
+
+template<typename T, Endian kEndian> inline T
+EndianValue<T, kEndian>::Get() const
+{
+    Bits bits;
+    std::memcpy(&bits, bytes_, sizeof(bits));
+    if (NeedsFlip()) bits = EndianUtils::Flip(bits);
+    T value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+template<typename T, Endian kEndian> inline void
+EndianValue<T, kEndian>::Set(T value)
+{
+    Bits bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if (NeedsFlip()) bits = EndianUtils::Flip(bits);
+    std::memcpy(bytes_, &bits, sizeof(bits));
+}
+
+// Offset relative to its own address, zero means null.
+template<typename T, typename TOffset = LittleEndian<int32_t>>
+class OffsetPtr {
+public:
+    OffsetPtr() = default;
+    OffsetPtr(const OffsetPtr&) = delete;
+    OffsetPtr& operator=(const OffsetPtr&) = delete;
+
+    explicit operator bool() const { return !IsNull(); }
+    const T& operator*() const { return *Get(); }
+    const T* operator->() const { return Get(); }
+
+    bool IsNull() const { return offset_ == 0; }
+    const T* Get() const;
+
+private:
+    TOffset offset_;
+};
+
+template<typename T, typename TOffset> inline const T*
+OffsetPtr<T, TOffset>::Get() const
+{
+    auto offset = static_cast<ptrdiff_t>(offset_);
+    return (offset != 0) ? reinterpret_cast<const T*>(reinterpret_cast<const uint8_t*>(this) + offset) : nullptr;
+}
+
+// Non-owning view of consecutive elements.
+template<typename T>
+class ArrayView {
+public:
+    ArrayView() = default;
+    explicit ArrayView(const T* data, size_t count) : data_(data), count_(count) {}
+
+    const T& operator[](size_t index) const { return data_[index]; }
+
+    bool IsEmpty() const { return count_ == 0; }
+    size_t GetCount() const { return count_; }
+    const T* GetPointer() const { return data_; }
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + count_; }
+
+private:
+    const T* data_ = nullptr;
+    size_t count_ = 0;
+};
+
+// Element count followed by the elements.
+template<typename T, typename TCount = LittleEndian<uint32_t>>
+class CountedArray {
+public:
+    CountedArray() = delete;
+    CountedArray(const CountedArray&) = delete;
+    CountedArray& operator=(const CountedArray&) = delete;
+
+    const T& operator[](size_t index) const { return GetView()[index]; }
+
+    size_t GetCount() const { return static_cast<size_t>(count_); }
+    // The elements are not checked against any range. Use BinaryView::GetCountedArray() for untrusted data.
+    ArrayView<T> GetView() const { return ArrayView<T>(reinterpret_cast<const T*>(this + 1), GetCount()); }
+
+private:
+    TCount count_;
+};
+
+// Bounds-checked access to structures laid out in a byte range, without copying them.
+class BinaryView {
+public:
+    BinaryView() = default;
+    explicit BinaryView(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+    explicit BinaryView(const MemoryStream& stream) : BinaryView(stream.GetPointer(), stream.GetSize()) {}
+
+    size_t GetSize() const { return size_; }
+    const uint8_t* GetPointer() const { return data_; }
+    // Returns nullptr if the object does not fit in the range.
+    template<typename T> const T* Get(size_t offset) const;
+    // Returns an empty view if the elements do not fit in the range.
+    template<typename T> ArrayView<T> GetArray(size_t offset, size_t count) const;
+    // Returns an empty view if the count or the elements do not fit in the range.
+    template<typename T, typename TCount = LittleEndian<uint32_t>> ArrayView<T> GetCountedArray(size_t offset) const;
+    // Returns nullptr if the object pointed does not fit in the range.
+    // Only the count of a CountedArray is checked, so use ResolveArray() to access its elements.
+    template<typename T, typename TOffset> const T* Resolve(const OffsetPtr<T, TOffset>& pointer) const;
+    // Returns an empty view if the count or the elements pointed do not fit in the range.
+    template<typename T, typename TCount, typename TOffset>
+    ArrayView<T> ResolveArray(const OffsetPtr<CountedArray<T, TCount>, TOffset>& pointer) const;
+    bool Contains(const void* pointer, size_t size) const;
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+template<typename T> inline const T*
+BinaryView::Get(size_t offset) const
+{
+    static_assert(std::is_trivially_copyable<T>::value, "BinaryView requires a trivially copyable type");
+    return (offset <= size_ && sizeof(T) <= size_ - offset) ? reinterpret_cast<const T*>(data_ + offset) : nullptr;
+}
+
+template<typename T> inline ArrayView<T>
+BinaryView::GetArray(size_t offset, size_t count) const
+{
+    static_assert(std::is_trivially_copyable<T>::value, "BinaryView requires a trivially copyable type");
+    if (offset > size_ || count > (size_ - offset) / sizeof(T)) return ArrayView<T>();
+    return ArrayView<T>(reinterpret_cast<const T*>(data_ + offset), count);
+}
+
+template<typename T, typename TCount> inline ArrayView<T>
+BinaryView::GetCountedArray(size_t offset) const
+{
+    auto count = Get<TCount>(offset);
+    if (count == nullptr) return ArrayView<T>();
+    return GetArray<T>(offset + sizeof(CountedArray<T, TCount>), static_cast<size_t>(*count));
+}
+
+template<typename T, typename TOffset> inline const T*
+BinaryView::Resolve(const OffsetPtr<T, TOffset>& pointer) const
+{
+    auto target = pointer.Get();
+    return (target != nullptr && Contains(target, sizeof(T))) ? target : nullptr;
+}
+
+template<typename T, typename TCount, typename TOffset> inline ArrayView<T>
+BinaryView::ResolveArray(const OffsetPtr<CountedArray<T, TCount>, TOffset>& pointer) const
+{
+    auto target = reinterpret_cast<const uint8_t*>(pointer.Get());
+    if (target == nullptr || !Contains(target, 0)) return ArrayView<T>();
+    return GetCountedArray<T, TCount>(static_cast<size_t>(target - data_));
+}
+
+inline bool
+BinaryView::Contains(const void* pointer, size_t size) const
+{
+    auto p = static_cast<const uint8_t*>(pointer);
+    return data_ <= p && p <= data_ + size_ && size <= static_cast<size_t>(data_ + size_ - p);
+}
+
+} // namespace miso
+
+#endif // MISO_BINARY_VIEW_HPP_
@@ -0,0 +1,138 @@
+#ifndef MISO_BINARY_XML_READER_HPP_
+#define MISO_BINARY_XML_READER_HPP_
+
+#include "miso/common.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "miso/binary_view.hpp"
+#include "miso/value.hpp"
+#include "miso/xml_reader.hpp"
+
+namespace miso {
+
+// How BinaryXmlReader::Open() decides whether a cache is of the current source.
+enum class BinaryXmlValidation { ModifiedTime, Hash };
+
+// Pull reader with the same API as XmlReader over a document compiled into a binary form.
+// The names and texts are deduplicated in a string table, each node is a fixed-size record
+// knowing the index of its end element, and the attribute values are stored parsed as Value,
+// so reading needs neither tokenizing nor allocating, and a subtree is skipped at once.
+// The compiled data can be kept in a cache file checked against the source by Open().
+class BinaryXmlReader {
+public:
+    static constexpr uint32_t kVersion = 1;
+
+    // Returns empty data if the reader reports an error.
+    static std::vector<uint8_t> Compile(XmlReader& reader, uint64_t source_size = 0, uint64_t source_modified_time = 0, uint64_t source_hash = 0);
+    static std::vector<uint8_t> Compile(const char* buffer, size_t size);
+    // Reads the cache if it is of the current source, otherwise compiles the source and writes the cache again.
+    // The source may be missing if the cache exists. compiled_out tells whether the source has been compiled.
+    static BinaryXmlReader Open(const char* filename, const char* cache_filename,
+        BinaryXmlValidation validation = BinaryXmlValidation::ModifiedTime, bool* compiled_out = nullptr);
+
+    BinaryXmlReader() = delete;
+    BinaryXmlReader(const BinaryXmlReader&) = delete;
+    BinaryXmlReader& operator=(const BinaryXmlReader&) = delete;
+    BinaryXmlReader(BinaryXmlReader&& other) = default;
+    BinaryXmlReader& operator=(BinaryXmlReader&&) = delete;
+    // The data is not copied and must outlive the reader. It may be a mapped file.
+    explicit BinaryXmlReader(const uint8_t* data, size_t size);
+    explicit BinaryXmlReader(std::vector<uint8_t>&& data);
+
+    bool CanRead() const { return !reached_to_end_; }
+    bool HasError() const { return !errors_.empty(); }
+    const std::vector<std::string>& GetErrors() const { return errors_; }
+    bool Read();
+    bool SkipSubtree();
+    bool MoveToElement(const char* element_name = nullptr, const char* attribute_name = nullptr, const char* attribute_value = nullptr);
+    bool MoveToElementInCurrentLevel(const char* element_name = nullptr, const char* attribute_name = nullptr, const char* attribute_value = nullptr);
+    bool MoveToEndElement() { return MoveToEndElementInside(false); }
+    bool MoveToEndOfParentElement() { return MoveToEndElementInside(true); }
+    XmlNodeType GetNodeType() const { return node_type_; }
+    std::string GetElementName() const { return std::string(GetElementNameView()); }
+    std::string GetContentText() const { return std::string(GetContentTextView()); }
+    const std::string GetAttributeValueString(const char* name) const { return std::string(GetAttributeValueView(name)); }
+    // The views point into the data and are valid while the data exists.
+    std::string_view GetElementNameView() const;
+    std::string_view GetContentTextView() const;
+    std::string_view GetAttributeValueView(const char* name) const;
+    // Returns the value parsed at compile time, or an invalid value if the attribute does not exist.
+    Value GetAttributeValue(const char* name) const;
+    const std::vector<XmlAttribute> GetAllAttributes() const;
+    int GetNestingLevel() const { return depth_; }
+
+private:
+    struct Header {
+        char magic[4];
+        LittleEndian<uint32_t> version;
+        LittleEndian<uint64_t> source_size;
+        LittleEndian<uint64_t> source_modified_time;
+        LittleEndian<uint64_t> source_hash;
+        LittleEndian<uint32_t> string_count;
+        LittleEndian<uint32_t> node_count;
+        LittleEndian<uint32_t> attribute_count;
+        LittleEndian<uint32_t> string_data_size;
+    };
+    // A string is terminated by '\0' in the string data.
+    struct StringRecord {
+        LittleEndian<uint32_t> offset;
+        LittleEndian<uint32_t> size;
+    };
+    // The name of an element or the text of a text node.
+    // The end of a start element is the index of its end element.
+    struct NodeRecord {
+        uint8_t type;
+        uint8_t reserved;
+        LittleEndian<uint16_t> depth;
+        LittleEndian<uint32_t> string_id;
+        LittleEndian<uint32_t> attribute_begin;
+        LittleEndian<uint32_t> attribute_count;
+        LittleEndian<uint32_t> end;
+    };
+    // A value which Value cannot be built from as is, such as an array, is stored as Array to be parsed when it is got.
+    struct AttributeRecord {
+        LittleEndian<uint32_t> name_id;
+        LittleEndian<uint32_t> value_id;
+        uint8_t value_type;
+        uint8_t unit;
+        uint8_t reserved[2];
+        LittleEndian<float> color[4];
+        LittleEndian<double> number;
+    };
+
+    static bool GetSourceStatus(const char* filename, uint64_t* size_out, uint64_t* modified_time_out);
+    static void EncodeValue(const char* str, AttributeRecord& record);
+
+    void Load();
+    bool Fail(const char* message);
+    bool MoveTo(size_t index);
+    bool MoveToElementInside(const char* element_name, const char* attribute_name, const char* attribute_value, bool only_current_level);
+    bool MoveToEndElementInside(bool end_of_parent);
+    std::string_view GetString(uint32_t id) const;
+    const AttributeRecord* FindAttribute(const char* name) const;
+
+    // A vector keeps the views valid when the reader is moved.
+    std::vector<uint8_t> owned_data_;
+    BinaryView view_;
+    const Header* header_ = nullptr;
+    ArrayView<StringRecord> strings_;
+    ArrayView<NodeRecord> nodes_;
+    ArrayView<AttributeRecord> attributes_;
+    const char* string_data_ = nullptr;
+    size_t index_ = 0;
+    XmlNodeType node_type_ = XmlNodeType::None;
+    bool reached_to_end_ = false;
+    int depth_ = 0;
+    std::vector<std::string> errors_;
+};
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "binary_xml_reader.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_BINARY_XML_READER_HPP_
@@ -0,0 +1,54 @@
+#ifndef MISO_CHECKSUM_HPP_
+#define MISO_CHECKSUM_HPP_
+
+#include "miso/common.hpp"
+
+namespace miso {
+
+enum class ChecksumType { Crc32c, XxHash64 };
+
+// Incremental checksum.
+// CRC32C uses the SSE4.2 crc32 instruction when the CPU supports it.
+class Checksum {
+public:
+    static uint32_t ComputeCrc32c(const void* data, size_t size);
+    static uint64_t ComputeXxHash64(const void* data, size_t size, uint64_t seed = 0);
+
+    Checksum() = delete;
+    Checksum(const Checksum&) = default;
+    Checksum& operator=(const Checksum&) = default;
+    explicit Checksum(ChecksumType type, uint64_t seed = 0);
+
+    ChecksumType GetType() const { return type_; }
+    uint64_t GetSize() const { return size_; }
+    uint64_t GetValue() const;
+    void Update(const void* data, size_t size);
+    void Reset();
+
+private:
+    static constexpr size_t kXxHashStripeSize = 32;
+
+    static uint32_t UpdateCrc32c(uint32_t crc, const uint8_t* data, size_t size);
+    static uint32_t UpdateCrc32cSoftware(uint32_t crc, const uint8_t* data, size_t size);
+    static uint32_t UpdateCrc32cHardware(uint32_t crc, const uint8_t* data, size_t size);
+    static bool IsCrc32cHardwareAvailable();
+    static const uint32_t* GetCrc32cTable();
+    static const uint8_t* ConsumeXxHashStripes(uint64_t* lanes, const uint8_t* data, const uint8_t* end);
+    static uint64_t FinalizeXxHash64(const uint64_t* lanes, uint64_t seed, uint64_t total_size, const uint8_t* rest, size_t rest_size);
+
+    ChecksumType type_ = ChecksumType::Crc32c;
+    uint64_t seed_ = 0;
+    uint64_t size_ = 0;
+    uint32_t crc_ = 0;
+    uint64_t lanes_[4] = {};
+    uint8_t stripe_[kXxHashStripeSize] = {};
+    size_t stripe_size_ = 0;
+};
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "checksum.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_CHECKSUM_HPP_
@@ -0,0 +1,50 @@
+#ifndef MISO_CHECKSUM_STREAM_HPP_
+#define MISO_CHECKSUM_STREAM_HPP_
+
+#include "miso/common.hpp"
+
+#include "miso/checksum.hpp"
+#include "miso/stream.hpp"
+
+namespace miso {
+
+// Computes a checksum over the bytes read through it from another stream, in the same pass as the read.
+// The checksum covers the stream from the beginning up to GetCheckedSize(). Bytes read again after
+// a rewind are not counted twice, and bytes skipped with SetPosition() are not counted until Verify().
+class ChecksumStream : public IStream {
+public:
+    ChecksumStream() = delete;
+    ChecksumStream(const ChecksumStream&) = delete;
+    ChecksumStream& operator=(const ChecksumStream&) = delete;
+    explicit ChecksumStream(IStream& stream, ChecksumType type, uint64_t seed = 0);
+
+    bool CanRead(size_t size = 1) const { return stream_.CanRead(size); }
+    uint8_t Read();
+    uint8_t Peek() const { return stream_.Peek(); }
+    size_t ReadBlock(uint8_t* buffer, size_t size);
+    size_t GetSize() const { return stream_.GetSize(); }
+    size_t GetPosition() const { return stream_.GetPosition(); }
+    void SetPosition(size_t position) { stream_.SetPosition(position); }
+
+    const Checksum& GetChecksum() const { return checksum_; }
+    size_t GetCheckedSize() const { return static_cast<size_t>(checksum_.GetSize()); }
+    // Reads the bytes not checksummed yet, then compares the checksum of the whole stream.
+    bool Verify(uint64_t expected_value);
+
+private:
+    // Large blocks are read and checksummed in slices, so that each slice is still in cache when it is checksummed.
+    static constexpr size_t kSliceSize = 64 * 1024;
+
+    void Update(size_t position, const uint8_t* data, size_t size);
+
+    IStream& stream_;
+    Checksum checksum_;
+};
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "checksum_stream.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_CHECKSUM_STREAM_HPP_
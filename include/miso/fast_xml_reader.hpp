@@ -0,0 +1,96 @@
+#ifndef MISO_FAST_XML_READER_HPP_
+#define MISO_FAST_XML_READER_HPP_
+
+#include "miso/common.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "miso/xml_reader.hpp"
+
+namespace miso {
+
+// Pull reader with the same API as XmlReader, tokenizing the document by itself instead of using libxml.
+// It is meant for trusted, well-formed UTF-8 documents without DTD:
+// the markup delimiters are found with SSE2, names, text and attribute values are views into the buffer,
+// and only the text containing character or entity references is decoded into a copy.
+// The nesting of the elements is checked, but other well-formedness constraints,
+// line end normalization and entities other than the predefined ones are not handled.
+// Comments, processing instructions, CDATA sections and the document type declaration are skipped.
+class FastXmlReader {
+public:
+    FastXmlReader() = delete;
+    FastXmlReader(const FastXmlReader&) = delete;
+    FastXmlReader& operator=(const FastXmlReader&) = delete;
+    FastXmlReader(FastXmlReader&& other) = default;
+    FastXmlReader& operator=(FastXmlReader&&) = delete;
+    explicit FastXmlReader(const char* filename);
+    // The buffer is not copied and must outlive the reader.
+    explicit FastXmlReader(const char* buffer, size_t size);
+
+    bool CanRead() const { return !reached_to_end_; }
+    bool HasError() const { return !errors_.empty(); }
+    const std::vector<std::string>& GetErrors() const { return errors_; }
+    bool Read();
+    bool SkipSubtree();
+    bool MoveToElement(const char* element_name = nullptr, const char* attribute_name = nullptr, const char* attribute_value = nullptr);
+    bool MoveToElementInCurrentLevel(const char* element_name = nullptr, const char* attribute_name = nullptr, const char* attribute_value = nullptr);
+    bool MoveToEndElement() { return MoveToEndElementInside(false); }
+    bool MoveToEndOfParentElement() { return MoveToEndElementInside(true); }
+    XmlNodeType GetNodeType() const { return node_type_; }
+    std::string GetElementName() const { return std::string(GetElementNameView()); }
+    std::string GetContentText() const { return std::string(GetContentTextView()); }
+    const std::string GetAttributeValueString(const char* name) const { return std::string(GetAttributeValueView(name)); }
+    // The views are valid until the reader moves to another node,
+    // and a decoded attribute value until the next GetAttributeValueView call.
+    std::string_view GetElementNameView() const;
+    std::string_view GetContentTextView() const;
+    std::string_view GetAttributeValueView(const char* name) const;
+    const std::vector<XmlAttribute> GetAllAttributes() const;
+    int GetNestingLevel() const { return depth_; }
+
+private:
+    struct RawAttribute {
+        std::string_view name;
+        std::string_view value;
+        bool has_reference = false;
+    };
+
+    static void DecodeReferences(std::string_view raw, std::string& decoded);
+
+    bool ReadStartTag();
+    bool ReadEndTag();
+    bool SkipMarkup();
+    bool SkipToEndTag();
+    bool MoveToElementInside(const char* element_name, const char* attribute_name, const char* attribute_value, bool only_current_level);
+    bool MoveToEndElementInside(bool end_of_parent);
+    const RawAttribute* FindAttribute(std::string_view name) const;
+    bool Fail(const char* message);
+
+    // A vector keeps the views valid when the reader is moved.
+    std::vector<char> owned_buffer_;
+    const char* begin_ = nullptr;
+    const char* current_ = nullptr;
+    const char* end_ = nullptr;
+    XmlNodeType node_type_ = XmlNodeType::None;
+    bool reached_to_end_ = false;
+    int depth_ = 0;
+    std::vector<std::string_view> open_elements_;
+    std::string_view element_name_;
+    std::vector<RawAttribute> attributes_;
+    std::string_view text_;
+    bool text_has_reference_ = false;
+    mutable std::string decoded_text_;
+    mutable bool text_decoded_ = false;
+    mutable std::string decoded_value_;
+    std::vector<std::string> errors_;
+};
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "fast_xml_reader.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_FAST_XML_READER_HPP_
@@ -0,0 +1,75 @@
+#ifndef MISO_HUGE_PAGE_ALLOCATOR_HPP_
+#define MISO_HUGE_PAGE_ALLOCATOR_HPP_
+
+#include "miso/common.hpp"
+
+#include <memory>
+#include <new>
+
+namespace miso {
+
+class HugePageUtils {
+public:
+    static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+    HugePageUtils() = delete;
+    HugePageUtils(const HugePageUtils&) = delete;
+    HugePageUtils(HugePageUtils&&) = delete;
+
+    // Allocates a region aligned to kHugePageSize and asks the OS to back it with huge pages.
+    // If huge pages are not available, the region is backed by normal pages.
+    // Returns nullptr if the region could not be allocated at all.
+    static void* Allocate(size_t size);
+    static void Deallocate(void* pointer, size_t size);
+    static size_t GetAllocationSize(size_t size) { return (size + kHugePageSize - 1) / kHugePageSize * kHugePageSize; }
+};
+
+// Serves allocations of kThreshold bytes or more from huge pages, and smaller ones from the default heap.
+// It is stateless, so it can be used with Buffer in the same way as std::allocator.
+template<typename T = uint8_t, size_t kThreshold = HugePageUtils::kHugePageSize>
+class HugePageAllocator {
+public:
+    using value_type = T;
+    template<typename U> struct rebind { using other = HugePageAllocator<U, kThreshold>; };
+
+    HugePageAllocator() = default;
+    template<typename U> HugePageAllocator(const HugePageAllocator<U, kThreshold>&) {}
+
+    T* allocate(size_t count);
+    void deallocate(T* pointer, size_t count);
+
+    bool operator==(const HugePageAllocator&) const { return true; }
+    bool operator!=(const HugePageAllocator&) const { return false; }
+};
+
+template<typename T, size_t kThreshold> inline T*
+HugePageAllocator<T, kThreshold>::allocate(size_t count)
+{
+    auto size = sizeof(T) * count;
+    if (size < kThreshold) {
+        return std::allocator<T>().allocate(count);
+    }
+    auto pointer = HugePageUtils::Allocate(size);
+    if (pointer == nullptr) throw std::bad_alloc();
+    return static_cast<T*>(pointer);
+}
+
+template<typename T, size_t kThreshold> inline void
+HugePageAllocator<T, kThreshold>::deallocate(T* pointer, size_t count)
+{
+    if (pointer == nullptr) return;
+    auto size = sizeof(T) * count;
+    if (size < kThreshold) {
+        std::allocator<T>().deallocate(pointer, count);
+    } else {
+        HugePageUtils::Deallocate(pointer, size);
+    }
+}
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "huge_page_allocator.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_HUGE_PAGE_ALLOCATOR_HPP_
@@ -17,8 +17,9 @@ public:
     bool CanRead(size_t size = 1) const { return begin_ != nullptr && (current_ + size) <= end_; }
     size_t GetSize() const { return static_cast<size_t>(end_ - begin_); }
     size_t GetPosition() const { return static_cast<size_t>(current_ - begin_); }
-    void SetPosition(size_t position) { current_ = ((begin_ + position) < end_) ? (begin_ + position) : end_; }
-    uint8_t Read() { return (current_ < end_) ? *current_++ : *(end_ - 1); }
+    const uint8_t* GetPointer() const { return begin_; }
+    void SetPosition(size_t position);
+    uint8_t Read();
     uint8_t Peek() const { return (current_ < end_) ? *current_ : *(end_ - 1); }
     size_t ReadBlock(uint8_t* buffer, size_t size);
 
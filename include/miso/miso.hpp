@@ -4,19 +4,37 @@
 // Available defines
 // -----------------
 // MISO_HEADER_ONLY
+// MISO_STREAM_STATS
 
 #include "miso/binary_reader.hpp"
+#include "miso/binary_view.hpp"
+#include "miso/binary_xml_reader.hpp"
 #include "miso/buffer.hpp"
+#include "miso/checksum.hpp"
+#include "miso/checksum_stream.hpp"
 #include "miso/color.hpp"
 #include "miso/colorspace_utils.hpp"
 #include "miso/endian_utils.hpp"
+#include "miso/fast_xml_reader.hpp"
 #include "miso/file_stream.hpp"
+#include "miso/huge_page_allocator.hpp"
 #include "miso/interpolator.hpp"
 #include "miso/memory_stream.hpp"
 #include "miso/numeric.hpp"
+#include "miso/pipe_stream.hpp"
+#include "miso/prefetch_file_stream.hpp"
 #include "miso/stream.hpp"
+#include "miso/stream_stats.hpp"
 #include "miso/string_utils.hpp"
 #include "miso/value.hpp"
+#include "miso/xml_batch.hpp"
+#include "miso/xml_dictionary.hpp"
+#include "miso/xml_element_index.hpp"
+#include "miso/xml_feed_reader.hpp"
 #include "miso/xml_reader.hpp"
+#include "miso/xml_reader_pool.hpp"
+#include "miso/xml_sax_parser.hpp"
+#include "miso/xml_selector.hpp"
+#include "miso/xml_split_parser.hpp"
 
 #endif // MISO_MISO_HPP_
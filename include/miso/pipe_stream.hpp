@@ -0,0 +1,61 @@
+#ifndef MISO_PIPE_STREAM_HPP_
+#define MISO_PIPE_STREAM_HPP_
+
+#include "miso/common.hpp"
+
+#include <vector>
+
+#include "miso/stream.hpp"
+
+namespace miso {
+
+// Reads from a non-seekable file descriptor such as a pipe or stdin through a bounded ring buffer.
+// GetSize() returns kUnknownSize until the end of the stream is reached.
+// SetPosition() can always go back rewind_size bytes from the furthest position read so far,
+// a position older than the bytes still held in the buffer is clamped to the oldest one.
+class PipeStream : public IStream {
+public:
+    static constexpr size_t kDefaultRewindSize = 4 * 1024;
+    static constexpr size_t kReadSize = 16 * 1024;
+
+    PipeStream() = delete;
+    PipeStream(const PipeStream&) = delete;
+    PipeStream& operator=(const PipeStream&) = delete;
+    PipeStream(PipeStream&& other) noexcept;
+    PipeStream& operator=(PipeStream&&) = delete;
+    // The file descriptor is not closed by PipeStream unless owns_fd is true.
+    explicit PipeStream(int fd, size_t rewind_size = kDefaultRewindSize, bool owns_fd = false);
+    ~PipeStream();
+
+    bool CanRead(size_t size = 1) const;
+    uint8_t Read();
+    uint8_t Peek() const;
+    size_t ReadBlock(uint8_t* buffer, size_t size);
+    size_t GetSize() const { return reached_to_end_ ? end_position_ : kUnknownSize; }
+    size_t GetPosition() const { return position_; }
+    void SetPosition(size_t position);
+    size_t GetRewindSize() const { return rewind_size_; }
+
+private:
+    bool FillBuffer(size_t size) const;
+    uint8_t* GetPointer(size_t position) const { return buffer_.data() + (position % buffer_.size()); }
+
+    int fd_ = -1;
+    bool owns_fd_ = false;
+    size_t rewind_size_ = 0;
+    size_t position_ = 0;
+    // Reading ahead changes only the buffered range, not the stream position,
+    // so it is allowed from CanRead() and Peek().
+    mutable std::vector<uint8_t> buffer_;
+    mutable size_t begin_position_ = 0;
+    mutable size_t end_position_ = 0;
+    mutable bool reached_to_end_ = false;
+};
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "pipe_stream.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_PIPE_STREAM_HPP_
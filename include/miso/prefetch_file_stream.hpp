@@ -0,0 +1,81 @@
+#ifndef MISO_PREFETCH_FILE_STREAM_HPP_
+#define MISO_PREFETCH_FILE_STREAM_HPP_
+
+#include "miso/common.hpp"
+
+#include <stdio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "miso/stream.hpp"
+
+namespace miso {
+
+// Reads a file on a background thread ahead of the consumer, so that parsing the first chunks overlaps reading the next ones.
+//
+//   PrefetchFileStream stream("large.xml");
+//   XmlReader reader(stream);
+//
+// The chunks are handed over through a single-producer single-consumer ring indexed by atomic counters,
+// and a thread sleeps only when the ring is empty or full.
+// Seeking backward out of the current chunk restarts reading from the position.
+class PrefetchFileStream : public IStream {
+public:
+    static constexpr size_t kDefaultChunkSize = 256 * 1024;
+    static constexpr size_t kDefaultChunkCount = 8;
+
+    PrefetchFileStream() = delete;
+    PrefetchFileStream(const PrefetchFileStream&) = delete;
+    PrefetchFileStream& operator=(const PrefetchFileStream&) = delete;
+    explicit PrefetchFileStream(const char* filename, size_t chunk_size = kDefaultChunkSize, size_t chunk_count = kDefaultChunkCount);
+    ~PrefetchFileStream();
+
+    bool CanRead(size_t size = 1) const;
+    uint8_t Read();
+    uint8_t Peek() const;
+    size_t ReadBlock(uint8_t* buffer, size_t size);
+    size_t GetSize() const { return stream_size_; }
+    size_t GetPosition() const { return chunk_position_ + offset_; }
+    void SetPosition(size_t position);
+
+private:
+    struct Chunk {
+        std::vector<uint8_t> data;
+        size_t size = 0;
+    };
+
+    void Start(size_t position);
+    void Stop();
+    void Produce(size_t position);
+    void Notify() const;
+    bool EnsureData() const;
+    bool AcquireChunk() const;
+
+    FILE* fp_ = nullptr;
+    size_t stream_size_ = 0;
+    std::vector<Chunk> chunks_;
+    // Numbers of the chunks filled by the producer and released by the consumer so far.
+    std::atomic<size_t> filled_count_{ 0 };
+    mutable std::atomic<size_t> released_count_{ 0 };
+    std::atomic<bool> produced_all_{ false };
+    std::atomic<bool> stop_requested_{ false };
+    mutable std::mutex mutex_;
+    mutable std::condition_variable condition_;
+    std::thread thread_;
+    // The current chunk is held by the consumer until it moves to the next one.
+    mutable const Chunk* current_ = nullptr;
+    mutable size_t chunk_position_ = 0;
+    mutable size_t offset_ = 0;
+};
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "prefetch_file_stream.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_PREFETCH_FILE_STREAM_HPP_
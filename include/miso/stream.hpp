@@ -3,11 +3,16 @@
 
 #include "miso/common.hpp"
 
+#include "miso/stream_stats.hpp"
+
 namespace miso {
 
 class IStream {
 public:
-    virtual ~IStream() = default;
+    // Returned by GetSize() when the size cannot be known until the end of the stream is reached.
+    static constexpr size_t kUnknownSize = SIZE_MAX;
+
+    virtual ~IStream() { MISO_STREAM_STATS_ONLY(StreamStats::AddGlobal(stats_);) }
 
     virtual bool CanRead(size_t size = 1) const = 0;
     virtual uint8_t Read() = 0;
@@ -16,9 +21,19 @@ public:
     virtual size_t GetSize() const = 0;
     virtual size_t GetPosition() const = 0;
     virtual void SetPosition(size_t position) = 0;
+    // All zero unless MISO_STREAM_STATS is defined.
+    const StreamStats& GetStats() const { return stats_; }
 
 protected:
     IStream() = default;
+    // A copy starts with its own counters so that nothing is added to the global stats twice.
+    IStream(const IStream&) {}
+    IStream& operator=(const IStream&) { return *this; }
+
+    // Declared regardless of MISO_STREAM_STATS, which compiles out only the counting,
+    // so that the layout of every stream is the same in the code built with and without it.
+    // Counters are updated from const members as well, such as a read-ahead in CanRead().
+    mutable StreamStats stats_;
 };
 
 } // namespace miso
@@ -0,0 +1,68 @@
+#ifndef MISO_STREAM_STATS_HPP_
+#define MISO_STREAM_STATS_HPP_
+
+#include "miso/common.hpp"
+
+#include <chrono>
+
+#ifdef MISO_STREAM_STATS
+#define MISO_STREAM_STATS_ONLY(...) __VA_ARGS__
+#else // MISO_STREAM_STATS
+#define MISO_STREAM_STATS_ONLY(...)
+#endif // MISO_STREAM_STATS
+
+namespace miso {
+
+// I/O counters of a stream.
+// They are collected only when MISO_STREAM_STATS is defined, otherwise every counter stays zero.
+struct StreamStats {
+    class Timer;
+
+    // Sum of the stats of all streams destroyed so far.
+    static StreamStats GetGlobal();
+    static void ResetGlobal();
+    static void AddGlobal(const StreamStats& stats);
+    static const StreamStats& GetEmpty();
+
+    StreamStats& operator+=(const StreamStats& other);
+
+    uint64_t delivered_bytes = 0;       // Bytes handed to the caller
+    uint64_t os_read_bytes = 0;         // Bytes read from the OS
+    uint64_t refill_count = 0;          // Number of times the internal buffer was refilled
+    uint64_t seek_count = 0;            // Number of SetPosition calls
+    uint64_t syscall_count = 0;         // Number of read and seek requests to the OS
+    uint64_t blocked_nanoseconds = 0;   // Time spent waiting for the OS
+
+private:
+    struct Global;
+    static Global& GetGlobalStorage();
+};
+
+// Adds the lifetime of the instance to blocked_nanoseconds.
+class StreamStats::Timer {
+public:
+    Timer() = delete;
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+    explicit Timer(StreamStats& stats) : stats_(stats), start_(std::chrono::steady_clock::now()) {}
+    ~Timer();
+
+private:
+    StreamStats& stats_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+inline
+StreamStats::Timer::~Timer()
+{
+    auto elapsed = std::chrono::steady_clock::now() - start_;
+    stats_.blocked_nanoseconds += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "stream_stats.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_STREAM_STATS_HPP_
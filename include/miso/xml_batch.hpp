@@ -0,0 +1,81 @@
+#ifndef MISO_XML_BATCH_HPP_
+#define MISO_XML_BATCH_HPP_
+
+#include "miso/common.hpp"
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "miso/xml_reader.hpp"
+
+namespace miso {
+
+// Receives the documents of XmlBatch, called on the worker threads at the same time.
+class IXmlBatchVisitor {
+public:
+    virtual ~IXmlBatchVisitor() = default;
+
+    // The reader is at the beginning of the document and is reused for another one after the call.
+    virtual void OnDocument(size_t index, XmlReader& reader) = 0;
+
+protected:
+    IXmlBatchVisitor() = default;
+};
+
+// Parses many independent documents in parallel.
+// Each worker takes the documents from its own queue and steals from the others when it runs out,
+// reading them with one XmlReader which is reset for each document.
+//
+//   XmlBatch batch;
+//   batch.AddFile("a.xml");
+//   batch.AddFile("b.xml");
+//   batch.Run(visitor);
+class XmlBatch {
+public:
+    XmlBatch() = default;
+    XmlBatch(const XmlBatch&) = delete;
+    XmlBatch& operator=(const XmlBatch&) = delete;
+
+    void AddFile(const char* filename);
+    // The buffer is not copied and must outlive Run().
+    void AddBuffer(const char* buffer, size_t size);
+    // The stream must outlive Run().
+    void AddStream(IStream& stream);
+    size_t GetCount() const { return documents_.size(); }
+    // Uses the calling thread and thread_count - 1 more threads, as many as the hardware threads if 0.
+    // Returns false if any document has an error.
+    bool Run(IXmlBatchVisitor& visitor, size_t thread_count = 0);
+    bool HasError() const;
+    // The errors of the document added at the index, collected by the last Run().
+    const std::vector<std::string>& GetErrors(size_t index) const { return errors_[index]; }
+
+private:
+    struct Document {
+        std::string filename;
+        const char* buffer = nullptr;
+        size_t size = 0;
+        IStream* stream = nullptr;
+    };
+    struct Worker {
+        std::mutex mutex;
+        std::deque<size_t> indices;
+    };
+
+    void Work(size_t worker_index, IXmlBatchVisitor& visitor);
+    bool TakeDocument(size_t worker_index, size_t* index_out);
+
+    std::vector<Document> documents_;
+    std::deque<Worker> workers_;
+    // Each document has its own slot, written only by the worker parsing it.
+    std::vector<std::vector<std::string>> errors_;
+};
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "xml_batch.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_XML_BATCH_HPP_
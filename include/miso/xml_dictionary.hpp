@@ -0,0 +1,45 @@
+#ifndef MISO_XML_DICTIONARY_HPP_
+#define MISO_XML_DICTIONARY_HPP_
+
+#include "miso/common.hpp"
+
+#include <initializer_list>
+#include <string_view>
+
+#include "miso/xml_reader.hpp"
+
+namespace miso {
+
+// Names interned once for the XmlSaxParsers of many documents, on any threads.
+// Each parser interns the names of its document in a dictionary of its own over this one, which it only reads,
+// so the names given on construction are shared and reported with the same pointers by every parser.
+// The dictionary cannot be changed after construction for the parsers to read it without locking.
+//
+//   XmlDictionary dictionary{ "member", "name" };
+//   parser.SetDictionary(&dictionary);
+//   // In the handler
+//   if (name.data() == member_name.data()) { ... }
+class XmlDictionary {
+public:
+    XmlDictionary() = delete;
+    XmlDictionary(const XmlDictionary&) = delete;
+    XmlDictionary& operator=(const XmlDictionary&) = delete;
+    explicit XmlDictionary(std::initializer_list<std::string_view> names);
+    ~XmlDictionary();
+
+    // Returns the name in the dictionary, or a view with null data if it is not.
+    std::string_view Find(std::string_view name) const;
+
+private:
+    friend class XmlSaxParser;
+
+    libxml::xmlDictPtr dict_ = nullptr;
+};
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "xml_dictionary.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_XML_DICTIONARY_HPP_
@@ -0,0 +1,146 @@
+#ifndef MISO_XML_ELEMENT_INDEX_HPP_
+#define MISO_XML_ELEMENT_INDEX_HPP_
+
+#include "miso/common.hpp"
+
+#include <climits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "miso/stream.hpp"
+
+namespace miso {
+
+// Offsets of the elements of a document in memory, found by a scan much faster than parsing.
+// The scan follows only the markup delimiters and quotes, so the errors of a malformed document
+// are found when the elements are read.
+// The keys are the raw values of the key attribute, without expanding entity references.
+//
+//   XmlElementIndex index;
+//   index.Build(buffer, size, "id");
+//   reader.SeekToElement(index, "element2");
+class XmlElementIndex {
+public:
+    static constexpr size_t kNotFound = SIZE_MAX;
+
+    struct Entry {
+        // Offsets of the '<' of the start tag and following the end tag
+        size_t begin;
+        size_t end;
+        int depth;
+        // Index of the parent entry, kNotFound for the root
+        size_t parent;
+        // Points into the buffer, with null data if the element has no key attribute.
+        std::string_view key;
+    };
+
+    XmlElementIndex() = default;
+    XmlElementIndex(const XmlElementIndex&) = delete;
+    XmlElementIndex& operator=(const XmlElementIndex&) = delete;
+
+    // The buffer is not copied and must outlive the index.
+    // Elements deeper than max_depth are not recorded. Returns false if the structure of the document is not found.
+    bool Build(const char* buffer, size_t size, const char* key_attribute_name = "id", int max_depth = INT_MAX);
+    const char* GetBuffer() const { return buffer_; }
+    size_t GetSize() const { return size_; }
+    size_t GetCount() const { return entries_.size(); }
+    // The entries are in document order, the root first.
+    const Entry& GetEntry(size_t index) const { return entries_[index]; }
+    // Returns the first entry with the key, or kNotFound.
+    size_t Find(std::string_view key) const;
+    // The content of the root is between the end of its start tag and the beginning of its end tag.
+    size_t GetContentBegin() const { return content_begin_; }
+    size_t GetContentEnd() const { return content_end_; }
+    // Empty if the root is an empty element.
+    const std::string& GetRootEndTag() const { return root_end_tag_; }
+    // Returns the prolog and the root start tag with the namespace declarations, xml:space, xml:lang and xml:base
+    // of the ancestors of the entry added, for the entry to be read as a child of the root in the scope of its ancestors.
+    std::string MakeScopePrefix(size_t index) const;
+
+private:
+    bool Scan(const char* key_attribute_name, int max_depth);
+
+    const char* buffer_ = nullptr;
+    size_t size_ = 0;
+    std::vector<Entry> entries_;
+    std::unordered_map<std::string_view, size_t> keys_;
+    size_t content_begin_ = 0;
+    size_t content_end_ = 0;
+    std::string root_end_tag_;
+};
+
+// Walks the elements of a document in memory one by one, following the markup as XmlElementIndex does.
+class XmlElementScanner {
+public:
+    static constexpr size_t kNotFound = SIZE_MAX;
+
+    XmlElementScanner() = default;
+    // The buffer is not copied and must outlive the scanner.
+    explicit XmlElementScanner(const char* buffer, size_t size);
+
+    // Moves to the start tag of the next element, which is a descendant of the current one unless it has been skipped.
+    // Returns false at the end of the document or on malformed markup.
+    bool Next();
+    // Moves past the end tag of the current element, so that Next() finds the element following it.
+    bool SkipElement();
+    // Offsets of the '<' of the current start tag and following the last markup scanned
+    size_t GetBegin() const { return begin_; }
+    size_t GetPosition() const { return position_; }
+    // Number of the elements open before the current one
+    int GetDepth() const { return depth_; }
+    size_t GetRootBegin() const { return root_begin_; }
+
+private:
+    const char* buffer_ = nullptr;
+    size_t size_ = 0;
+    size_t position_ = 0;
+    size_t begin_ = 0;
+    size_t root_begin_ = kNotFound;
+    int depth_ = 0;
+    // True before the first element, so that Next() does not count it as open
+    bool empty_ = true;
+};
+
+// Document made of the prolog and the root start tag of an indexed document, a range of its content,
+// and the root end tag. The range is read from the buffer of the index without being copied.
+// If the index has not been built, the document is the range alone.
+class XmlFragmentStream : public IStream {
+public:
+    XmlFragmentStream() = delete;
+    XmlFragmentStream(const XmlFragmentStream&) = delete;
+    XmlFragmentStream& operator=(const XmlFragmentStream&) = delete;
+    // The index must outlive the stream.
+    explicit XmlFragmentStream(const XmlElementIndex& index, size_t begin, size_t end);
+    // The prefix in place of the prolog and the root start tag of the index is kept by the stream.
+    explicit XmlFragmentStream(std::string prefix, const XmlElementIndex& index, size_t begin, size_t end);
+    // The strings must outlive the stream.
+    explicit XmlFragmentStream(std::string_view prefix, std::string_view body, std::string_view suffix);
+
+    bool CanRead(size_t size = 1) const { return position_ + size <= GetSize(); }
+    uint8_t Read();
+    uint8_t Peek() const;
+    size_t ReadBlock(uint8_t* buffer, size_t size);
+    size_t GetSize() const { return segments_[0].size + segments_[1].size + segments_[2].size; }
+    size_t GetPosition() const { return position_; }
+    void SetPosition(size_t position);
+
+private:
+    struct Segment {
+        const char* data;
+        size_t size;
+    };
+
+    Segment segments_[3];
+    size_t position_ = 0;
+    std::string prefix_;
+};
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "xml_element_index.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_XML_ELEMENT_INDEX_HPP_
@@ -0,0 +1,78 @@
+#ifndef MISO_XML_FEED_READER_HPP_
+#define MISO_XML_FEED_READER_HPP_
+
+#include "miso/common.hpp"
+
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "miso/xml_reader.hpp"
+#include "miso/xml_sax_parser.hpp"
+
+namespace miso {
+
+enum class XmlReadResult { Node, NeedMoreData, End };
+
+// Pull reader of a document given in chunks as they arrive, for an event loop not to wait for the whole document.
+// Each chunk is parsed at once and the nodes completed by it are queued,
+// so Read() returns NeedMoreData only when the next node depends on the data not given yet.
+//
+//   reader.Feed(chunk, size);
+//   while (reader.Read() == XmlReadResult::Node) { ... }
+//
+// A start element is held until the next node is known, and an element without child nodes is reported
+// as an empty element. Text around a comment is reported as one node, and a CDATA section as text.
+class XmlFeedReader : private IXmlSaxHandler {
+public:
+    XmlFeedReader();
+    XmlFeedReader(const XmlFeedReader&) = delete;
+    XmlFeedReader& operator=(const XmlFeedReader&) = delete;
+
+    // Returns false once parsing has been stopped by a fatal error, or if the end of data has been told.
+    bool Feed(const char* data, size_t size);
+    // Tells that no more data is given.
+    void FinishFeeding();
+    XmlReadResult Read();
+    // The errors include warnings, which do not stop reading.
+    bool HasError() const { return parser_.HasError(); }
+    const std::vector<std::string>& GetErrors() const { return parser_.GetErrors(); }
+    XmlNodeType GetNodeType() const { return node_.type; }
+    std::string GetElementName() const { return std::string(GetElementNameView()); }
+    std::string GetContentText() const { return std::string(GetContentTextView()); }
+    const std::string GetAttributeValueString(const char* name) const { return std::string(GetAttributeValueView(name)); }
+    // The views are valid until the next Read() call.
+    std::string_view GetElementNameView() const;
+    std::string_view GetContentTextView() const;
+    std::string_view GetAttributeValueView(const char* name) const;
+    const std::vector<XmlAttribute>& GetAllAttributes() const { return node_.attributes; }
+    int GetNestingLevel() const { return node_.depth; }
+
+private:
+    struct Node {
+        XmlNodeType type = XmlNodeType::None;
+        int depth = 0;
+        // Name of an element or content of a text node.
+        std::string text;
+        std::vector<XmlAttribute> attributes;
+    };
+
+    void OnStartElement(std::string_view name, ArrayView<XmlSaxAttribute> attributes) override;
+    void OnEndElement(std::string_view name) override;
+    void OnText(std::string_view text) override;
+
+    XmlSaxParser parser_;
+    bool finished_ = false;
+    int depth_ = 0;
+    std::deque<Node> nodes_;
+    Node node_;
+};
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "xml_feed_reader.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_XML_FEED_READER_HPP_
@@ -3,12 +3,22 @@
 
 #include "miso/common.hpp"
 
+#include <deque>
+#include <initializer_list>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "miso/stream.hpp"
+#include "miso/value.hpp"
+
 namespace miso {
 
 namespace libxml {
+#include "libxml/parser.h"
 #include "libxml/xmlreader.h"
 }
 
@@ -16,6 +26,7 @@ class XmlAttribute {
 public:
     XmlAttribute() = delete;
     XmlAttribute(const char* name, const char* value) : name_(name), value_(value) {}
+    XmlAttribute(std::string name, std::string value) : name_(std::move(name)), value_(std::move(value)) {}
 
     const std::string& GetName() const { return name_; }
     const std::string& GetValue() const { return value_; }
@@ -25,46 +36,271 @@ private:
     std::string value_;
 };
 
+// Name interned in the dictionary of an XmlReader, compared by pointer instead of by string.
+// An atom can be compared only with atoms of the reader which interned it.
+class XmlAtom {
+public:
+    XmlAtom() = default;
+
+    bool operator==(const XmlAtom& other) const { return name_ == other.name_; }
+    bool operator!=(const XmlAtom& other) const { return name_ != other.name_; }
+
+    bool IsNull() const { return name_ == nullptr; }
+    std::string_view GetName() const { return (name_ != nullptr) ? std::string_view(name_) : std::string_view(); }
+
+private:
+    friend class XmlReader;
+    friend class XmlAttributeCursor;
+
+    explicit XmlAtom(const char* name) : name_(name) {}
+    static XmlAtom FromCurrentNode(libxml::xmlTextReaderPtr reader);
+
+    const char* name_ = nullptr;
+};
+
+// Set of attribute names to be visited by XmlAttributeCursor, the others are skipped.
+class XmlAttributeFilter {
+public:
+    static constexpr size_t kNotFound = SIZE_MAX;
+
+    XmlAttributeFilter() = delete;
+    XmlAttributeFilter(std::initializer_list<const char*> names) : names_(names.begin(), names.end()) {}
+
+    size_t GetCount() const { return names_.size(); }
+    const std::string& GetName(size_t index) const { return names_[index]; }
+    size_t Find(std::string_view name) const;
+
+private:
+    std::vector<std::string> names_;
+};
+
+// Visits the attributes of the current element without allocating.
+// The names and values are valid until the next Next() call.
+//
+//   for (auto cursor = reader.GetAttributeCursor(); cursor.Next();) {
+//       cursor.GetName(); cursor.GetValue();
+//   }
+class XmlAttributeCursor {
+public:
+    XmlAttributeCursor() = delete;
+    XmlAttributeCursor(const XmlAttributeCursor&) = delete;
+    XmlAttributeCursor& operator=(const XmlAttributeCursor&) = delete;
+    XmlAttributeCursor(XmlAttributeCursor&& other) noexcept;
+    XmlAttributeCursor& operator=(XmlAttributeCursor&&) = delete;
+    ~XmlAttributeCursor() { Finish(); }
+
+    bool Next();
+    std::string_view GetName() const;
+    std::string_view GetValue() const;
+    XmlAtom GetNameAtom() const;
+    // Index of the current attribute name in the filter.
+    size_t GetFilterIndex() const { return filter_index_; }
+
+private:
+    friend class XmlReader;
+
+    explicit XmlAttributeCursor(libxml::xmlTextReaderPtr reader, const XmlAttributeFilter* filter);
+
+    void Finish();
+
+    libxml::xmlTextReaderPtr reader_ = nullptr;
+    const XmlAttributeFilter* filter_ = nullptr;
+    bool started_ = false;
+    bool on_attribute_ = false;
+    size_t filter_index_ = XmlAttributeFilter::kNotFound;
+    size_t found_count_ = 0;
+};
+
+class XmlElementIndex;
+class XmlElementScanner;
+class XmlFragmentStream;
+
 enum class XmlNodeType { None, StartElement, EmptyElement, EndElement, Text };
 
+// Options of libxml's parser and of XmlReader itself, kept over Reset().
+struct XmlReaderOptions {
+    // Drops whitespace between elements in the parser (XML_PARSE_NOBLANKS).
+    bool no_blanks = false;
+    // Stores short texts in their nodes instead of allocating them (XML_PARSE_COMPACT).
+    bool compact = false;
+    // Lifts the limits of the parser on the depth and the sizes of the nodes (XML_PARSE_HUGE).
+    bool huge = false;
+    // Parses CDATA sections as text, merged with the texts around them (XML_PARSE_NOCDATA).
+    bool no_cdata = false;
+    // Reports adjacent texts and CDATA sections as one Text node, and drops the ones only of whitespace.
+    bool coalesce_text = false;
+    // Follows the reader of a buffer with a scanner so that CaptureSubtree() can find the elements in the buffer.
+    bool capture_subtrees = false;
+    // Keeps the values parsed by GetAttributeValue() and the like, each distinct text parsed once.
+    // The reader holds a copy of each text with its value until Reset(), up to kMaxCachedValueCount texts,
+    // after which the other texts are parsed each time.
+    bool cache_attribute_values = false;
+
+    int GetParserOptions() const;
+};
+
+// Element with its subtree captured by XmlReader::CaptureSubtree(), to be read later by another XmlReader.
+// It refers to the buffer of the document, which must outlive it, and can be read on any thread.
+// The element is read in a document of the prolog of the original and a parent declaring the namespaces in scope.
+class XmlSubtree {
+public:
+    XmlSubtree() = default;
+
+    bool IsNull() const { return buffer_ == nullptr; }
+    // The bytes of the element in the document
+    std::string_view GetSource() const { return std::string_view(buffer_ + begin_, end_ - begin_); }
+
+private:
+    friend class XmlReader;
+
+    const char* buffer_ = nullptr;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+    std::string prefix_;
+    std::string suffix_;
+    // Whether the element is in a parent made by the prefix and the suffix, which is not for the root.
+    bool wrapped_ = false;
+};
+
+// Receives the content of a Text node from XmlReader::ReadContentChunks().
+class IXmlContentSink {
+public:
+    virtual ~IXmlContentSink() = default;
+
+    // The chunk points into the node and is valid during the call. Returns false to stop the reading.
+    virtual bool OnContentChunk(std::string_view chunk) = 0;
+
+protected:
+    IXmlContentSink() = default;
+};
+
 class XmlReader {
 public:
+    static constexpr size_t kDefaultContentChunkSize = 64 * 1024;
+
     XmlReader() = delete;
     XmlReader(const XmlReader& other) = delete;
     XmlReader& operator=(const XmlReader&) = delete;
     XmlReader(XmlReader&& other) noexcept;
     XmlReader& operator=(XmlReader&&) = delete;
-    explicit XmlReader(const char* filename);
-    explicit XmlReader(const char* buffer, size_t size);
+    explicit XmlReader(const char* filename, const XmlReaderOptions& options = XmlReaderOptions());
+    explicit XmlReader(const char* buffer, size_t size, const XmlReaderOptions& options = XmlReaderOptions());
+    // The document is pulled from the stream while being read, so the stream must outlive the reader.
+    explicit XmlReader(IStream& stream, const XmlReaderOptions& options = XmlReaderOptions());
+    // Reads the element of the subtree, which must outlive the reader, from its start.
+    explicit XmlReader(const XmlSubtree& subtree, const XmlReaderOptions& options = XmlReaderOptions());
     ~XmlReader();
 
+    // Parses another document reusing the parser with its buffers and dictionary, so the atoms stay valid.
+    // Cursors and selections over the previous document must not be used any more.
+    bool Reset(const char* filename);
+    bool Reset(const char* buffer, size_t size);
+    bool Reset(IStream& stream);
+    bool Reset(const XmlSubtree& subtree);
+    // Moves to the element with the key in the index without reading the document before it.
+    // The element is read from a document made of it between the root start and end tags of the indexed document,
+    // so the nesting levels and line numbers are of that document. The namespaces, xml:space and xml:lang declared
+    // by its ancestors are declared by the root start tag. The index must outlive the reading.
+    bool SeekToElement(const XmlElementIndex& index, std::string_view key);
+    // Releases the document and closes its file. The reader can be used again with Reset().
+    void Close();
     bool CanRead() const { return reader_ != nullptr && !reached_to_end_; }
     bool HasError() { return !errors_.empty(); }
     const std::vector<std::string>& GetErrors() { return errors_; }
     bool Read();
+    // Skips the descendants and the end of the current start element, and moves to the node following them.
+    // The subtree is passed over inside libxml without being reported node by node.
+    bool SkipSubtree();
+    // Moves past the current element as SkipSubtree() does, returning a handle to read the element later.
+    // Only a reader of a buffer with capture_subtrees set can capture, in which case its steps over the elements
+    // are replayed on the buffer by a scan much faster than parsing. Otherwise the handle is null and the reader does not move.
+    XmlSubtree CaptureSubtree();
     bool MoveToElement(const char* element_name = nullptr, const char* attribute_name = nullptr, const char* attribute_value = nullptr);
     bool MoveToElementInCurrentLevel(const char* element_name = nullptr, const char* attribute_name = nullptr, const char* attribute_value = nullptr);
+    bool MoveToElement(XmlAtom element_atom, const char* attribute_name = nullptr, const char* attribute_value = nullptr);
+    bool MoveToElementInCurrentLevel(XmlAtom element_atom, const char* attribute_name = nullptr, const char* attribute_value = nullptr);
     bool MoveToEndElement() { return MoveToEndElementInside(false); }
     bool MoveToEndOfParentElement() { return MoveToEndElementInside(true); }
     XmlNodeType GetNodeType() const { return node_type_; }
-    std::string GetElementName() const;
-    std::string GetContentText() const;
-    const std::string GetAttributeValueString(const char* name) const;
+    std::string GetElementName() const { return std::string(GetElementNameView()); }
+    std::string GetContentText() const { return std::string(GetContentTextView()); }
+    const std::string GetAttributeValueString(const char* name) const { return std::string(GetAttributeValueView(name)); }
+    // The views point into libxml's strings and are valid until the reader moves to another node.
+    // A value of an attribute containing entity references is built in a buffer shared by all attributes,
+    // in which case it is valid only until the next GetAttributeValueView call.
+    // GetAttributeValueView returns a view with null data if the attribute does not exist.
+    std::string_view GetElementNameView() const;
+    std::string_view GetContentTextView() const;
+    std::string_view GetAttributeValueView(const char* name) const;
+    // Parses the value of the attribute in libxml's string. Invalid if the attribute does not exist
+    // or the whole value is not of the type.
+    Value GetAttributeValue(const char* name) const;
+    Numeric GetAttributeNumeric(const char* name) const;
+    Color GetAttributeColor(const char* name) const;
+    // Passes the content of the current Text node to the sink in chunks of at most chunk_size bytes,
+    // split between UTF-8 characters, without copying it. Returns false if not on a Text node or stopped by the sink.
+    bool ReadContentChunks(IXmlContentSink& sink, size_t chunk_size = kDefaultContentChunkSize) const;
+    // Returns a null atom for a node other than an element.
+    XmlAtom GetElementAtom() const;
+    // The atom is valid while the reader exists.
+    XmlAtom Intern(const char* name) const;
     const std::vector<XmlAttribute> GetAllAttributes() const;
-    int GetNestingLevel() const { return libxml::xmlTextReaderDepth(reader_); }
+    // The filter must outlive the cursor.
+    XmlAttributeCursor GetAttributeCursor(const XmlAttributeFilter* filter = nullptr) const;
+    int GetNestingLevel() const { return has_pending_node_ ? text_depth_ : libxml::xmlTextReaderDepth(reader_); }
 
 private:
-    XmlReader(libxml::xmlParserInputBufferPtr buffer);
+    friend class XmlDictionary;
+    friend class XmlSelection;
+
+    // The skips recorded before the scanner is synchronized
+    static constexpr size_t kMaxScanSkips = 1024;
+    static constexpr size_t kMaxCachedValueCount = 4096;
+
+    XmlReader(libxml::xmlParserInputBufferPtr buffer, const XmlReaderOptions& options);
 
-    bool MoveToElementInside(const char* element_name, const char* attribute_name, const char* attribute_value, bool current_level);
+    static void InitializeParser();
+    bool FinishReset(int result);
+    bool OpenFragment(std::unique_ptr<XmlFragmentStream> stream, bool wrapped);
+    int ReadNode();
+    int NextNode();
+    void CountElement(int result);
+    void StartScan(const char* buffer, size_t size);
+    bool SyncScanner();
+    bool BuildSubtreeContext(XmlSubtree& subtree) const;
+    bool UpdateNodeType();
+    bool CoalesceText();
+    bool MoveToElementInside(const char* element_name, XmlAtom element_atom, const char* attribute_name, const char* attribute_value, bool current_level);
     bool MoveToEndElementInside(bool end_of_parent);
+    std::string_view GetAttributeValueViewInside(const char* name) const;
+    const Value* GetCachedValue(std::string_view value) const;
+    static int ReadStream(void* context, char* buffer, int size);
     static void ErrorHandler(void* arg, const char* msg, libxml::xmlParserSeverities severity, libxml::xmlTextReaderLocatorPtr locator);
 
     libxml::xmlParserInputBufferPtr buffer_ = nullptr;
+    // The document given by SeekToElement()
+    std::unique_ptr<IStream> fragment_stream_;
     libxml::xmlTextReaderPtr reader_ = nullptr;
     XmlNodeType node_type_ = XmlNodeType::None;
     bool reached_to_end_ = false;
     std::vector<std::string> errors_;
+    XmlReaderOptions options_;
+    // The texts coalesced into the Text node reported, read past by libxml to the node reported next
+    std::string text_;
+    int text_depth_ = 0;
+    bool has_pending_node_ = false;
+    int pending_result_ = 0;
+    // The buffer being read if subtrees are captured, whose scanner follows the reader.
+    // The scanner is synchronized lazily: each element skipped with its subtree is recorded
+    // with the number of the elements read before it.
+    const char* scan_buffer_ = nullptr;
+    std::unique_ptr<XmlElementScanner> scanner_;
+    std::vector<size_t> scan_skips_;
+    size_t scan_read_count_ = 0;
+    // The values parsed by the interned texts
+    mutable std::unordered_map<std::string_view, Value> attribute_values_;
+    // The texts of the values, not moved when added so that the keys stay valid
+    mutable std::deque<std::string> attribute_value_texts_;
 };
 
 } // namespace miso
@@ -0,0 +1,74 @@
+#ifndef MISO_XML_READER_POOL_HPP_
+#define MISO_XML_READER_POOL_HPP_
+
+#include "miso/common.hpp"
+
+#include <memory>
+#include <vector>
+
+#include "miso/xml_reader.hpp"
+
+namespace miso {
+
+class XmlReaderPool;
+
+// Reader borrowed from XmlReaderPool, given back when destroyed.
+class PooledXmlReader {
+public:
+    PooledXmlReader() = delete;
+    PooledXmlReader(const PooledXmlReader&) = delete;
+    PooledXmlReader& operator=(const PooledXmlReader&) = delete;
+    PooledXmlReader(PooledXmlReader&& other) noexcept = default;
+    PooledXmlReader& operator=(PooledXmlReader&&) = delete;
+    ~PooledXmlReader();
+
+    XmlReader& operator*() const { return *reader_; }
+    XmlReader* operator->() const { return reader_.get(); }
+
+private:
+    friend class XmlReaderPool;
+
+    explicit PooledXmlReader(XmlReaderPool& pool, std::unique_ptr<XmlReader> reader) : pool_(&pool), reader_(std::move(reader)) {}
+
+    XmlReaderPool* pool_ = nullptr;
+    std::unique_ptr<XmlReader> reader_;
+};
+
+// Keeps readers to be reset for the next documents,
+// so that parsing many small documents does not create and free a parser for each of them.
+// A pool is not thread-safe. GetForCurrentThread() gives a pool for each thread,
+// and a reader must be given back on the thread it has been acquired.
+class XmlReaderPool {
+public:
+    static constexpr size_t kDefaultCapacity = 8;
+
+    static XmlReaderPool& GetForCurrentThread();
+
+    XmlReaderPool(const XmlReaderPool&) = delete;
+    XmlReaderPool& operator=(const XmlReaderPool&) = delete;
+    explicit XmlReaderPool(size_t capacity = kDefaultCapacity) : capacity_(capacity) {}
+
+    // The pool must outlive the readers acquired.
+    PooledXmlReader Acquire(const char* filename);
+    // The buffer is not copied and must outlive the use of the reader.
+    PooledXmlReader Acquire(const char* buffer, size_t size);
+    // The stream must outlive the use of the reader.
+    PooledXmlReader Acquire(IStream& stream);
+    size_t GetIdleCount() const { return idle_readers_.size(); }
+
+private:
+    friend class PooledXmlReader;
+
+    void Release(std::unique_ptr<XmlReader> reader);
+
+    size_t capacity_;
+    std::vector<std::unique_ptr<XmlReader>> idle_readers_;
+};
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "xml_reader_pool.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_XML_READER_POOL_HPP_
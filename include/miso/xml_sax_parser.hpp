@@ -0,0 +1,109 @@
+#ifndef MISO_XML_SAX_PARSER_HPP_
+#define MISO_XML_SAX_PARSER_HPP_
+
+#include "miso/common.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "miso/binary_view.hpp"
+#include "miso/stream.hpp"
+#include "miso/xml_dictionary.hpp"
+#include "miso/xml_reader.hpp"
+
+namespace miso {
+
+namespace libxml {
+#include "libxml/parser.h"
+}
+
+struct XmlSaxAttribute {
+    std::string_view name;
+    std::string_view value;
+};
+
+// Receives the nodes from XmlSaxParser.
+// The views are valid only during the call.
+class IXmlSaxHandler {
+public:
+    virtual ~IXmlSaxHandler() = default;
+
+    virtual void OnStartElement(std::string_view name, ArrayView<XmlSaxAttribute> attributes) { (void)name; (void)attributes; }
+    virtual void OnEndElement(std::string_view name) { (void)name; }
+    // Text only of whitespace is not reported. A CDATA section is reported as text.
+    virtual void OnText(std::string_view text) { (void)text; }
+
+protected:
+    IXmlSaxHandler() = default;
+};
+
+// Parses a whole document with the SAX2 interface of libxml, calling the handler for each node.
+// It builds no tree and is faster than XmlReader when pulling nodes is not needed.
+// An empty element is reported as a start element followed by an end element.
+class XmlSaxParser {
+public:
+    static constexpr size_t kChunkSize = 64 * 1024;
+
+    XmlSaxParser() = delete;
+    XmlSaxParser(const XmlSaxParser&) = delete;
+    XmlSaxParser& operator=(const XmlSaxParser&) = delete;
+    explicit XmlSaxParser(IXmlSaxHandler& handler) : handler_(handler) {}
+    ~XmlSaxParser();
+
+    // Names found in the dictionary are reported with its pointers from the next document.
+    // The dictionary is shared with the other parsers given it, and must outlive the parsing.
+    void SetDictionary(const XmlDictionary* dictionary) { dictionary_ = dictionary; }
+    bool Parse(const char* filename);
+    bool Parse(const char* buffer, size_t size);
+    bool Parse(IStream& stream);
+    // Parses a document given in chunks as they arrive: Begin(), Feed() for each chunk, and End().
+    // Feed() returns false once parsing has been stopped.
+    bool Begin();
+    bool Feed(const char* data, size_t size);
+    bool End();
+    // Can be called from the handler to stop parsing.
+    void Stop();
+    // True once parsing has been stopped, by Stop() or by a fatal error. Warnings and recoverable errors do not stop it.
+    bool IsStopped() const;
+    bool HasError() const { return !errors_.empty(); }
+    const std::vector<std::string>& GetErrors() const { return errors_; }
+
+private:
+#if LIBXML_VERSION >= 21200
+    using ErrorPointer = const libxml::xmlError*;
+#else
+    using ErrorPointer = libxml::xmlErrorPtr;
+#endif
+
+    bool UseDictionary();
+    bool FeedChunk(const char* data, size_t size, bool terminate);
+    void FlushText();
+
+    static void OnStartElementNs(void* context, const libxml::xmlChar* local_name, const libxml::xmlChar* prefix, const libxml::xmlChar* uri,
+        int namespace_count, const libxml::xmlChar** namespaces, int attribute_count, int defaulted_count, const libxml::xmlChar** attributes);
+    static void OnEndElementNs(void* context, const libxml::xmlChar* local_name, const libxml::xmlChar* prefix, const libxml::xmlChar* uri);
+    static void OnCharacters(void* context, const libxml::xmlChar* text, int length);
+    static void OnStructuredError(void* context, ErrorPointer error);
+    static std::string_view MakeName(const libxml::xmlChar* local_name, const libxml::xmlChar* prefix, std::string& buffer);
+    static std::string_view DecodeValue(const char* value, const char* value_end, std::string& buffer);
+
+    IXmlSaxHandler& handler_;
+    const XmlDictionary* dictionary_ = nullptr;
+    libxml::xmlParserCtxtPtr context_ = nullptr;
+    // Text is reported at once even if libxml delivers it in pieces.
+    std::string text_;
+    std::string name_;
+    std::vector<XmlSaxAttribute> attributes_;
+    std::vector<std::string> attribute_names_;
+    std::vector<std::string> attribute_values_;
+    std::vector<std::string> errors_;
+};
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "xml_sax_parser.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_XML_SAX_PARSER_HPP_
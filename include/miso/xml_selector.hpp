@@ -0,0 +1,110 @@
+#ifndef MISO_XML_SELECTOR_HPP_
+#define MISO_XML_SELECTOR_HPP_
+
+#include "miso/common.hpp"
+
+#include <string>
+#include <vector>
+
+#include "miso/xml_reader.hpp"
+
+namespace miso {
+
+// Element selector compiled from a text such as "element[@tag='*'] > sub-element".
+//
+//   selector  := [ '>' ] step { ( '>' | ' ' ) step }
+//   step      := ( name | '*' ) { '[@' attribute [ '=' quoted-value ] ']' }
+//
+// "a b" selects b under a at any depth, "a > b" selects b whose parent is a.
+// A leading '>' makes the first step match only the children of the element the search starts from.
+// A selector is immutable once compiled and can be shared by any number of XmlSelection.
+class XmlSelector {
+public:
+    static constexpr size_t kMaxStepCount = 63;
+
+    XmlSelector() = delete;
+    XmlSelector(const XmlSelector&) = default;
+    XmlSelector& operator=(const XmlSelector&) = default;
+    explicit XmlSelector(const char* selector);
+
+    bool IsValid() const { return error_.empty(); }
+    const std::string& GetError() const { return error_; }
+
+private:
+    friend class XmlSelection;
+
+    struct Predicate {
+        std::string attribute_name;
+        std::string attribute_value;
+        bool has_value = false;
+    };
+
+    struct Step {
+        // Empty for '*'
+        std::string element_name;
+        bool is_child = false;
+        size_t predicate_begin = 0;
+        size_t predicate_end = 0;
+    };
+
+    bool Compile(const char* selector);
+
+    std::vector<Step> steps_;
+    std::vector<Predicate> predicates_;
+    std::string error_;
+};
+
+// Moves an XmlReader to the elements selected by an XmlSelector, one by one.
+// The search covers the descendants of the current start element, or the rest of the parent element otherwise,
+// and subtrees in which no element can be selected are skipped without being read node by node.
+// Between Next() calls, the reader can be moved inside the element selected last.
+//
+//   XmlSelection selection(reader, selector);
+//   while (selection.Next()) {
+//       reader.GetAttributeValueView("id");
+//   }
+class XmlSelection {
+public:
+    XmlSelection() = delete;
+    XmlSelection(const XmlSelection&) = delete;
+    XmlSelection& operator=(const XmlSelection&) = delete;
+    // The reader and the selector must outlive the selection.
+    explicit XmlSelection(XmlReader& reader, const XmlSelector& selector);
+
+    bool Next();
+
+private:
+    // Bit i set means the steps before i have been matched by the element or its ancestors.
+    using States = uint64_t;
+
+    struct Entry {
+        const libxml::xmlNode* node = nullptr;
+        States states = 0;
+    };
+
+    States GetStates(const libxml::xmlNode* node, int relative_depth);
+    States Advance(States parent_states, const libxml::xmlNode* node) const;
+    bool MatchesStep(size_t step_index, const libxml::xmlNode* node) const;
+    static bool MatchesName(const libxml::xmlChar* name, const libxml::xmlNs* ns, const libxml::xmlChar* atom);
+    static bool MatchesValue(const libxml::xmlAttr* attribute, const std::string& value);
+
+    XmlReader& reader_;
+    const XmlSelector& selector_;
+    States final_state_ = 0;
+    int scope_depth_ = -1;
+    bool started_ = false;
+    bool finished_ = false;
+    // Interned names of the steps and the predicates, nullptr for '*'
+    std::vector<const libxml::xmlChar*> element_atoms_;
+    std::vector<const libxml::xmlChar*> attribute_atoms_;
+    // States of the ancestors indexed by the depth relative to the scope, valid within a Next() call
+    std::vector<Entry> entries_;
+};
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "xml_selector.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_XML_SELECTOR_HPP_
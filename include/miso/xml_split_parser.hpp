@@ -0,0 +1,64 @@
+#ifndef MISO_XML_SPLIT_PARSER_HPP_
+#define MISO_XML_SPLIT_PARSER_HPP_
+
+#include "miso/common.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "miso/xml_batch.hpp"
+#include "miso/xml_element_index.hpp"
+
+namespace miso {
+
+// Parses one large document in parallel by splitting it between the children of the root element.
+// The buffer is scanned once for the boundaries of the root's children, which is much faster than parsing it,
+// and each part is read by its own XmlReader as a document of the prolog and the root start tag of the original,
+// the children in the part, and the root end tag.
+// The visitor is given the index of each part, which follows document order. Merging the results is up to the visitor.
+// The errors are reported for each part, and line numbers in them are of the part documents, not of the original.
+//
+//   XmlSplitParser parser(buffer, size);
+//   parser.Run(visitor);
+class XmlSplitParser {
+public:
+    static constexpr size_t kPartsPerThread = 4;
+
+    XmlSplitParser() = delete;
+    XmlSplitParser(const XmlSplitParser&) = delete;
+    XmlSplitParser& operator=(const XmlSplitParser&) = delete;
+    // The buffer is not copied and must outlive the parser.
+    explicit XmlSplitParser(const char* buffer, size_t size);
+
+    // Splits the document into up to part_count parts of about the same size.
+    // Returns false if the structure of the document is not found, in which case it is read as one part.
+    bool Split(size_t part_count);
+    size_t GetPartCount() const { return parts_.size(); }
+    // Splits the document by the thread count unless Split() has been called.
+    // The visitor is called for each part with the reader at its beginning.
+    bool Run(IXmlBatchVisitor& visitor, size_t thread_count = 0);
+    bool HasError() const { return batch_ != nullptr && batch_->HasError(); }
+    const std::vector<std::string>& GetErrors(size_t part_index) const { return batch_->GetErrors(part_index); }
+
+private:
+    struct Part {
+        size_t begin;
+        size_t end;
+    };
+
+    const char* buffer_;
+    size_t size_;
+    XmlElementIndex index_;
+    std::vector<Part> parts_;
+    std::vector<std::unique_ptr<XmlFragmentStream>> streams_;
+    std::unique_ptr<XmlBatch> batch_;
+};
+
+} // namespace miso
+
+#ifdef MISO_HEADER_ONLY
+#include "xml_split_parser.cpp"
+#endif // MISO_HEADER_ONLY
+
+#endif // MISO_XML_SPLIT_PARSER_HPP_
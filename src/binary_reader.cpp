@@ -9,24 +9,30 @@ namespace miso {
 
 MISO_INLINE
 BinaryReader::BinaryReader(BinaryReader&& other) noexcept :
-    BinaryReader(other.stream_, other.target_endian_)
+    BinaryReader(other.stream_, other.target_endian_, other.owns_stream_)
 {
     other.stream_ = nullptr;
 }
 
 MISO_INLINE
 BinaryReader::BinaryReader(const char* filename, Endian endian) :
-    BinaryReader(new FileStream(filename), endian)
+    BinaryReader(new FileStream(filename), endian, true)
 {}
 
 MISO_INLINE
 BinaryReader::BinaryReader(const uint8_t* buffer, size_t size, Endian endian) :
-    BinaryReader(new MemoryStream(buffer, size), endian)
+    BinaryReader(new MemoryStream(buffer, size), endian, true)
 {}
 
 MISO_INLINE
-BinaryReader::BinaryReader(IStream* stream, Endian endian) :
+BinaryReader::BinaryReader(IStream& stream, Endian endian) :
+    BinaryReader(&stream, endian, false)
+{}
+
+MISO_INLINE
+BinaryReader::BinaryReader(IStream* stream, Endian endian, bool owns_stream) :
     stream_(stream),
+    owns_stream_(owns_stream),
     native_endian_(EndianUtils::GetNativeEndian()),
     target_endian_(endian == Endian::Native ? native_endian_ : endian)
 {}
@@ -34,7 +40,7 @@ BinaryReader::BinaryReader(IStream* stream, Endian endian) :
 MISO_INLINE
 BinaryReader::~BinaryReader()
 {
-    delete stream_;
+    if (owns_stream_) delete stream_;
 }
 
 MISO_INLINE size_t
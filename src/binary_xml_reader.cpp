@@ -0,0 +1,460 @@
+#include "miso/binary_xml_reader.hpp"
+
+#include <sys/stat.h>
+
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+#include "miso/checksum.hpp"
+#include "miso/file_stream.hpp"
+#include "miso/string_utils.hpp"
+
+namespace miso {
+
+namespace {
+
+const char kMagic[4] = { 'M', 'X', 'B', 'C' };
+
+template<typename T> void
+AppendRecords(std::vector<uint8_t>& data, const T* records, size_t count)
+{
+    auto p = reinterpret_cast<const uint8_t*>(records);
+    data.insert(data.end(), p, p + sizeof(T) * count);
+}
+
+std::vector<uint8_t>
+ReadFileData(const char* filename)
+{
+    std::vector<uint8_t> data;
+    FileStream stream(filename);
+    if (!stream.CanRead()) return data;
+    data.resize(stream.GetSize());
+    data.resize(stream.ReadBlock(data.data(), data.size()));
+    return data;
+}
+
+// The cache is written to a temporary file first not to leave a broken one.
+void
+WriteFileData(const char* filename, const std::vector<uint8_t>& data)
+{
+    auto temporary_filename = std::string(filename) + ".tmp";
+    auto fp = fopen(temporary_filename.c_str(), "wb");
+    if (fp == nullptr) return;
+    bool written = fwrite(data.data(), 1, data.size(), fp) == data.size();
+    written = (fclose(fp) == 0) && written;
+    if (written) {
+        std::remove(filename);
+        written = (std::rename(temporary_filename.c_str(), filename) == 0);
+    }
+    if (!written) std::remove(temporary_filename.c_str());
+}
+
+} // namespace
+
+MISO_INLINE std::vector<uint8_t>
+BinaryXmlReader::Compile(XmlReader& reader, uint64_t source_size, uint64_t source_modified_time, uint64_t source_hash)
+{
+    std::vector<StringRecord> strings;
+    std::string string_data;
+    std::unordered_map<std::string, uint32_t> string_ids;
+    auto intern = [&](std::string_view str) {
+        auto result = string_ids.emplace(std::string(str), static_cast<uint32_t>(strings.size()));
+        if (result.second) {
+            StringRecord record;
+            record.offset = static_cast<uint32_t>(string_data.size());
+            record.size = static_cast<uint32_t>(str.size());
+            strings.push_back(record);
+            string_data.append(str.data(), str.size());
+            string_data += '\0';
+        }
+        return result.first->second;
+    };
+
+    std::vector<NodeRecord> nodes;
+    std::vector<AttributeRecord> attributes;
+    std::vector<size_t> open_elements;
+    while (reader.Read()) {
+        auto type = reader.GetNodeType();
+        NodeRecord node = {};
+        node.type = static_cast<uint8_t>(type);
+        node.depth = static_cast<uint16_t>(reader.GetNestingLevel());
+        node.end = static_cast<uint32_t>(nodes.size());
+        if (type == XmlNodeType::Text) {
+            node.string_id = intern(reader.GetContentTextView());
+        } else {
+            node.string_id = intern(reader.GetElementNameView());
+        }
+
+        if (type == XmlNodeType::StartElement || type == XmlNodeType::EmptyElement) {
+            node.attribute_begin = static_cast<uint32_t>(attributes.size());
+            for (auto cursor = reader.GetAttributeCursor(); cursor.Next();) {
+                AttributeRecord attribute = {};
+                attribute.name_id = intern(cursor.GetName());
+                attribute.value_id = intern(cursor.GetValue());
+                EncodeValue(std::string(cursor.GetValue()).c_str(), attribute);
+                attributes.push_back(attribute);
+            }
+            node.attribute_count = static_cast<uint32_t>(attributes.size() - node.attribute_begin);
+            if (type == XmlNodeType::StartElement) open_elements.push_back(nodes.size());
+        } else if (type == XmlNodeType::EndElement && !open_elements.empty()) {
+            nodes[open_elements.back()].end = node.end;
+            open_elements.pop_back();
+        }
+        nodes.push_back(node);
+    }
+    if (reader.HasError()) return std::vector<uint8_t>();
+
+    Header header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.source_size = source_size;
+    header.source_modified_time = source_modified_time;
+    header.source_hash = source_hash;
+    header.string_count = static_cast<uint32_t>(strings.size());
+    header.node_count = static_cast<uint32_t>(nodes.size());
+    header.attribute_count = static_cast<uint32_t>(attributes.size());
+    header.string_data_size = static_cast<uint32_t>(string_data.size());
+
+    std::vector<uint8_t> data;
+    data.reserve(sizeof(Header) + sizeof(StringRecord) * strings.size() + sizeof(NodeRecord) * nodes.size() +
+        sizeof(AttributeRecord) * attributes.size() + string_data.size());
+    AppendRecords(data, &header, 1);
+    AppendRecords(data, strings.data(), strings.size());
+    AppendRecords(data, nodes.data(), nodes.size());
+    AppendRecords(data, attributes.data(), attributes.size());
+    AppendRecords(data, string_data.data(), string_data.size());
+    return data;
+}
+
+MISO_INLINE std::vector<uint8_t>
+BinaryXmlReader::Compile(const char* buffer, size_t size)
+{
+    XmlReader reader(buffer, size);
+    return Compile(reader, size, 0, Checksum::ComputeXxHash64(buffer, size));
+}
+
+MISO_INLINE BinaryXmlReader
+BinaryXmlReader::Open(const char* filename, const char* cache_filename, BinaryXmlValidation validation, bool* compiled_out)
+{
+    if (compiled_out != nullptr) *compiled_out = false;
+    uint64_t source_size = 0;
+    uint64_t source_modified_time = 0;
+    bool has_source = GetSourceStatus(filename, &source_size, &source_modified_time);
+    std::vector<uint8_t> source;
+    bool source_read = false;
+
+    auto cache_data = ReadFileData(cache_filename);
+    if (!cache_data.empty()) {
+        BinaryXmlReader reader(std::move(cache_data));
+        bool fresh = !reader.HasError();
+        if (fresh && has_source) {
+            fresh = (reader.header_->source_size == source_size);
+            if (fresh && validation == BinaryXmlValidation::ModifiedTime) {
+                fresh = (reader.header_->source_modified_time == source_modified_time);
+            } else if (fresh) {
+                source = ReadFileData(filename);
+                source_read = true;
+                fresh = (reader.header_->source_hash == Checksum::ComputeXxHash64(source.data(), source.size()));
+            }
+        }
+        if (fresh) return reader;
+    }
+
+    if (!source_read) source = ReadFileData(filename);
+    BinaryXmlReader reader((std::vector<uint8_t>()));
+    if (!has_source) {
+        reader.errors_.assign(1, "Cannot open file");
+        return reader;
+    }
+    XmlReader xml_reader(reinterpret_cast<const char*>(source.data()), source.size());
+    auto data = Compile(xml_reader, source_size, source_modified_time, Checksum::ComputeXxHash64(source.data(), source.size()));
+    if (data.empty()) {
+        reader.errors_ = xml_reader.GetErrors();
+        return reader;
+    }
+    if (compiled_out != nullptr) *compiled_out = true;
+    WriteFileData(cache_filename, data);
+    return BinaryXmlReader(std::move(data));
+}
+
+MISO_INLINE
+BinaryXmlReader::BinaryXmlReader(const uint8_t* data, size_t size) :
+    view_(data, size)
+{
+    Load();
+}
+
+MISO_INLINE
+BinaryXmlReader::BinaryXmlReader(std::vector<uint8_t>&& data) :
+    owned_data_(std::move(data)),
+    view_(owned_data_.data(), owned_data_.size())
+{
+    Load();
+}
+
+MISO_INLINE bool
+BinaryXmlReader::Read()
+{
+    if (reached_to_end_) return false;
+    return MoveTo((node_type_ == XmlNodeType::None) ? 0 : index_ + 1);
+}
+
+MISO_INLINE bool
+BinaryXmlReader::SkipSubtree()
+{
+    if (reached_to_end_ || node_type_ != XmlNodeType::StartElement) return Read();
+    return MoveTo(nodes_[index_].end + 1);
+}
+
+MISO_INLINE bool
+BinaryXmlReader::MoveToElement(const char* element_name, const char* attribute_name, const char* attribute_value)
+{
+    return MoveToElementInside(element_name, attribute_name, attribute_value, false);
+}
+
+MISO_INLINE bool
+BinaryXmlReader::MoveToElementInCurrentLevel(const char* element_name, const char* attribute_name, const char* attribute_value)
+{
+    return MoveToElementInside(element_name, attribute_name, attribute_value, true);
+}
+
+MISO_INLINE std::string_view
+BinaryXmlReader::GetElementNameView() const
+{
+    if (reached_to_end_) return std::string_view();
+    if (node_type_ == XmlNodeType::StartElement ||
+        node_type_ == XmlNodeType::EmptyElement ||
+        node_type_ == XmlNodeType::EndElement) {
+        return GetString(nodes_[index_].string_id);
+    }
+    return std::string_view();
+}
+
+MISO_INLINE std::string_view
+BinaryXmlReader::GetContentTextView() const
+{
+    if (reached_to_end_ || node_type_ != XmlNodeType::Text) return std::string_view();
+    return GetString(nodes_[index_].string_id);
+}
+
+MISO_INLINE std::string_view
+BinaryXmlReader::GetAttributeValueView(const char* name) const
+{
+    auto attribute = FindAttribute(name);
+    return (attribute != nullptr) ? GetString(attribute->value_id) : std::string_view();
+}
+
+MISO_INLINE Value
+BinaryXmlReader::GetAttributeValue(const char* name) const
+{
+    auto attribute = FindAttribute(name);
+    if (attribute == nullptr) return Value();
+    switch (static_cast<ValueType>(attribute->value_type)) {
+    case ValueType::Numeric:
+        return Value(Numeric(attribute->number, static_cast<NumericUnit>(attribute->unit)));
+    case ValueType::Color:
+        return Value(Color(attribute->color[0], attribute->color[1], attribute->color[2], attribute->color[3]));
+    case ValueType::Array:
+        return Value(GetString(attribute->value_id).data());
+    default:
+        return Value();
+    }
+}
+
+MISO_INLINE const std::vector<XmlAttribute>
+BinaryXmlReader::GetAllAttributes() const
+{
+    std::vector<XmlAttribute> attributes;
+    if (reached_to_end_) return attributes;
+    if (node_type_ == XmlNodeType::StartElement || node_type_ == XmlNodeType::EmptyElement) {
+        auto& node = nodes_[index_];
+        attributes.reserve(node.attribute_count);
+        for (uint32_t i = 0; i < node.attribute_count; ++i) {
+            auto& attribute = attributes_[node.attribute_begin + i];
+            attributes.emplace_back(std::string(GetString(attribute.name_id)), std::string(GetString(attribute.value_id)));
+        }
+    }
+    return attributes;
+}
+
+MISO_INLINE bool
+BinaryXmlReader::GetSourceStatus(const char* filename, uint64_t* size_out, uint64_t* modified_time_out)
+{
+#ifdef _WIN32
+    struct _stat64 status;
+    if (_stat64(filename, &status) != 0) return false;
+#else
+    struct stat status;
+    if (stat(filename, &status) != 0) return false;
+#endif
+    *size_out = static_cast<uint64_t>(status.st_size);
+    *modified_time_out = static_cast<uint64_t>(status.st_mtime);
+    return true;
+}
+
+MISO_INLINE void
+BinaryXmlReader::EncodeValue(const char* str, AttributeRecord& record)
+{
+    Value value(str);
+    auto type = value.GetType();
+    record.value_type = static_cast<uint8_t>(type);
+    if (type == ValueType::Numeric) {
+        // A numeric built from its value may differ in the float flag, as that of "1.0".
+        auto& numeric = value.AsNumeric();
+        if (Numeric(numeric.GetValue(), numeric.GetUnit()).IsFloat() != numeric.IsFloat()) {
+            record.value_type = static_cast<uint8_t>(ValueType::Array);
+            return;
+        }
+        record.number = numeric.GetValue();
+        record.unit = static_cast<uint8_t>(numeric.GetUnit());
+    } else if (type == ValueType::Color) {
+        auto& color = value.AsColor();
+        record.color[0] = color.R;
+        record.color[1] = color.G;
+        record.color[2] = color.B;
+        record.color[3] = color.A;
+    }
+}
+
+// Every reference in the data is checked here so that the nodes can be read without checks.
+MISO_INLINE void
+BinaryXmlReader::Load()
+{
+    header_ = view_.Get<Header>(0);
+    if (header_ == nullptr || std::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0 || header_->version != kVersion) {
+        Fail("Invalid binary XML header");
+        return;
+    }
+
+    size_t offset = sizeof(Header);
+    strings_ = view_.GetArray<StringRecord>(offset, header_->string_count);
+    offset += sizeof(StringRecord) * strings_.GetCount();
+    nodes_ = view_.GetArray<NodeRecord>(offset, header_->node_count);
+    offset += sizeof(NodeRecord) * nodes_.GetCount();
+    attributes_ = view_.GetArray<AttributeRecord>(offset, header_->attribute_count);
+    offset += sizeof(AttributeRecord) * attributes_.GetCount();
+    auto string_data = view_.GetArray<char>(offset, header_->string_data_size);
+    string_data_ = string_data.GetPointer();
+    if (strings_.GetCount() != header_->string_count ||
+        nodes_.GetCount() != header_->node_count ||
+        attributes_.GetCount() != header_->attribute_count ||
+        string_data.GetCount() != header_->string_data_size) {
+        Fail("Truncated binary XML");
+        return;
+    }
+
+    auto string_count = strings_.GetCount();
+    for (auto& record : strings_) {
+        uint64_t end = static_cast<uint64_t>(record.offset) + record.size;
+        if (end >= string_data.GetCount() || string_data_[end] != '\0') {
+            Fail("Invalid string in binary XML");
+            return;
+        }
+    }
+    for (size_t i = 0; i < nodes_.GetCount(); ++i) {
+        auto& node = nodes_[i];
+        if (node.type < static_cast<uint8_t>(XmlNodeType::StartElement) || node.type > static_cast<uint8_t>(XmlNodeType::Text) ||
+            node.string_id >= string_count || node.end < i || node.end >= nodes_.GetCount() ||
+            static_cast<uint64_t>(node.attribute_begin) + node.attribute_count > attributes_.GetCount()) {
+            Fail("Invalid node in binary XML");
+            return;
+        }
+    }
+    for (auto& attribute : attributes_) {
+        if (attribute.name_id >= string_count || attribute.value_id >= string_count ||
+            attribute.value_type > static_cast<uint8_t>(ValueType::Color)) {
+            Fail("Invalid attribute in binary XML");
+            return;
+        }
+    }
+}
+
+MISO_INLINE bool
+BinaryXmlReader::Fail(const char* message)
+{
+    errors_.push_back(StringUtils::Format("[ERROR] %s", message));
+    reached_to_end_ = true;
+    return false;
+}
+
+MISO_INLINE bool
+BinaryXmlReader::MoveTo(size_t index)
+{
+    if (index >= nodes_.GetCount()) {
+        reached_to_end_ = true;
+        return false;
+    }
+    index_ = index;
+    auto& node = nodes_[index];
+    node_type_ = static_cast<XmlNodeType>(node.type);
+    depth_ = node.depth;
+    return true;
+}
+
+MISO_INLINE bool
+BinaryXmlReader::MoveToElementInside(const char* element_name, const char* attribute_name, const char* attribute_value, bool only_current_level)
+{
+    int level = depth_;
+    bool moved = only_current_level ? SkipSubtree() : Read();
+    while (moved) {
+        if (node_type_ == XmlNodeType::StartElement || node_type_ == XmlNodeType::EmptyElement) {
+            bool found = (!only_current_level || depth_ == level) &&
+                (element_name == nullptr || GetElementNameView() == element_name);
+            if (found && attribute_name != nullptr) {
+                auto value = GetAttributeValueView(attribute_name);
+                found = value.data() != nullptr && (attribute_value == nullptr || value == attribute_value);
+            }
+            if (found) return true;
+            moved = only_current_level ? SkipSubtree() : Read();
+        } else if (node_type_ == XmlNodeType::EndElement && only_current_level && depth_ < level) {
+            return false;
+        } else {
+            moved = Read();
+        }
+    }
+    return false;
+}
+
+MISO_INLINE bool
+BinaryXmlReader::MoveToEndElementInside(bool end_of_parent)
+{
+    if (reached_to_end_) return false;
+    int depth = end_of_parent ? depth_ - 1 : depth_;
+    if (node_type_ == XmlNodeType::StartElement) {
+        MoveTo(nodes_[index_].end);
+        if (!end_of_parent) return true;
+    } else if (!end_of_parent) {
+        return false;
+    }
+
+    // Every child element is jumped over to its end.
+    while (Read()) {
+        if (node_type_ == XmlNodeType::EndElement && depth_ == depth) return true;
+        if (node_type_ == XmlNodeType::StartElement) MoveTo(nodes_[index_].end);
+    }
+    return false;
+}
+
+MISO_INLINE std::string_view
+BinaryXmlReader::GetString(uint32_t id) const
+{
+    auto& record = strings_[id];
+    return std::string_view(string_data_ + record.offset, record.size);
+}
+
+MISO_INLINE const BinaryXmlReader::AttributeRecord*
+BinaryXmlReader::FindAttribute(const char* name) const
+{
+    if (reached_to_end_) return nullptr;
+    if (node_type_ != XmlNodeType::StartElement && node_type_ != XmlNodeType::EmptyElement) return nullptr;
+    auto& node = nodes_[index_];
+    for (uint32_t i = 0; i < node.attribute_count; ++i) {
+        auto& attribute = attributes_[node.attribute_begin + i];
+        if (GetString(attribute.name_id) == name) return &attribute;
+    }
+    return nullptr;
+}
+
+} // namespace miso
@@ -0,0 +1,305 @@
+#include "miso/checksum.hpp"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MISO_CHECKSUM_X86
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif // _MSC_VER
+#endif
+
+#if defined(MISO_CHECKSUM_X86) && defined(__GNUC__)
+#define MISO_CHECKSUM_TARGET_SSE42 __attribute__((target("sse4.2")))
+#else
+#define MISO_CHECKSUM_TARGET_SSE42
+#endif
+
+namespace miso {
+
+namespace {
+
+const uint32_t kCrc32cPolynomial = 0x82F63B78UL;
+const uint64_t kXxHashPrime1 = 11400714785074694791ULL;
+const uint64_t kXxHashPrime2 = 14029467366897019727ULL;
+const uint64_t kXxHashPrime3 = 1609587929392839161ULL;
+const uint64_t kXxHashPrime4 = 9650029242287828579ULL;
+const uint64_t kXxHashPrime5 = 2870177450012600261ULL;
+
+inline uint32_t
+ReadLittle32(const uint8_t* p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+        (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint64_t
+ReadLittle64(const uint8_t* p)
+{
+    return static_cast<uint64_t>(ReadLittle32(p)) | (static_cast<uint64_t>(ReadLittle32(p + 4)) << 32);
+}
+
+inline uint64_t
+RotateLeft(uint64_t value, int count)
+{
+    return (value << count) | (value >> (64 - count));
+}
+
+inline uint64_t
+XxHashRound(uint64_t lane, uint64_t input)
+{
+    lane += input * kXxHashPrime2;
+    lane = RotateLeft(lane, 31);
+    return lane * kXxHashPrime1;
+}
+
+inline uint64_t
+XxHashMergeRound(uint64_t hash, uint64_t lane)
+{
+    hash ^= XxHashRound(0, lane);
+    return hash * kXxHashPrime1 + kXxHashPrime4;
+}
+
+} // namespace
+
+MISO_INLINE uint32_t
+Checksum::ComputeCrc32c(const void* data, size_t size)
+{
+    return UpdateCrc32c(0xFFFFFFFFUL, static_cast<const uint8_t*>(data), size) ^ 0xFFFFFFFFUL;
+}
+
+MISO_INLINE uint64_t
+Checksum::ComputeXxHash64(const void* data, size_t size, uint64_t seed)
+{
+    Checksum checksum(ChecksumType::XxHash64, seed);
+    checksum.Update(data, size);
+    return checksum.GetValue();
+}
+
+MISO_INLINE
+Checksum::Checksum(ChecksumType type, uint64_t seed) :
+    type_(type),
+    seed_(seed)
+{
+    Reset();
+}
+
+MISO_INLINE uint64_t
+Checksum::GetValue() const
+{
+    if (type_ == ChecksumType::Crc32c) {
+        return crc_ ^ 0xFFFFFFFFUL;
+    } else {
+        return FinalizeXxHash64(lanes_, seed_, size_, stripe_, stripe_size_);
+    }
+}
+
+MISO_INLINE void
+Checksum::Update(const void* data, size_t size)
+{
+    auto p = static_cast<const uint8_t*>(data);
+    size_ += size;
+    if (type_ == ChecksumType::Crc32c) {
+        crc_ = UpdateCrc32c(crc_, p, size);
+        return;
+    }
+
+    if (stripe_size_ + size < kXxHashStripeSize) {
+        std::memcpy(stripe_ + stripe_size_, p, size);
+        stripe_size_ += size;
+        return;
+    }
+    auto end = p + size;
+    if (stripe_size_ > 0) {
+        auto fill_size = kXxHashStripeSize - stripe_size_;
+        std::memcpy(stripe_ + stripe_size_, p, fill_size);
+        ConsumeXxHashStripes(lanes_, stripe_, stripe_ + kXxHashStripeSize);
+        p += fill_size;
+        stripe_size_ = 0;
+    }
+    p = ConsumeXxHashStripes(lanes_, p, end);
+    stripe_size_ = static_cast<size_t>(end - p);
+    std::memcpy(stripe_, p, stripe_size_);
+}
+
+MISO_INLINE void
+Checksum::Reset()
+{
+    size_ = 0;
+    crc_ = 0xFFFFFFFFUL;
+    lanes_[0] = seed_ + kXxHashPrime1 + kXxHashPrime2;
+    lanes_[1] = seed_ + kXxHashPrime2;
+    lanes_[2] = seed_;
+    lanes_[3] = seed_ - kXxHashPrime1;
+    stripe_size_ = 0;
+}
+
+MISO_INLINE uint32_t
+Checksum::UpdateCrc32c(uint32_t crc, const uint8_t* data, size_t size)
+{
+    static const bool hardware_available = IsCrc32cHardwareAvailable();
+    return hardware_available ?
+        UpdateCrc32cHardware(crc, data, size) :
+        UpdateCrc32cSoftware(crc, data, size);
+}
+
+// Slicing-by-8
+MISO_INLINE uint32_t
+Checksum::UpdateCrc32cSoftware(uint32_t crc, const uint8_t* data, size_t size)
+{
+    auto table = GetCrc32cTable();
+    while (size >= 8) {
+        auto low = ReadLittle32(data) ^ crc;
+        auto high = ReadLittle32(data + 4);
+        crc =
+            table[7 * 256 + (low & 0xFF)] ^ table[6 * 256 + ((low >> 8) & 0xFF)] ^
+            table[5 * 256 + ((low >> 16) & 0xFF)] ^ table[4 * 256 + (low >> 24)] ^
+            table[3 * 256 + (high & 0xFF)] ^ table[2 * 256 + ((high >> 8) & 0xFF)] ^
+            table[1 * 256 + ((high >> 16) & 0xFF)] ^ table[0 * 256 + (high >> 24)];
+        data += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#ifdef MISO_CHECKSUM_X86
+
+MISO_INLINE MISO_CHECKSUM_TARGET_SSE42 uint32_t
+Checksum::UpdateCrc32cHardware(uint32_t crc, const uint8_t* data, size_t size)
+{
+    while (size > 0 && (reinterpret_cast<uintptr_t>(data) & 7) != 0) {
+        crc = _mm_crc32_u8(crc, *data++);
+        --size;
+    }
+#if defined(_M_X64) || defined(__x86_64__)
+    uint64_t crc64 = crc;
+    while (size >= 8) {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        crc64 = _mm_crc32_u64(crc64, value);
+        data += 8;
+        size -= 8;
+    }
+    crc = static_cast<uint32_t>(crc64);
+#endif
+    while (size >= 4) {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        crc = _mm_crc32_u32(crc, value);
+        data += 4;
+        size -= 4;
+    }
+    while (size-- > 0) {
+        crc = _mm_crc32_u8(crc, *data++);
+    }
+    return crc;
+}
+
+MISO_INLINE bool
+Checksum::IsCrc32cHardwareAvailable()
+{
+#ifdef _MSC_VER
+    int info[4] = {};
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else // _MSC_VER
+    return __builtin_cpu_supports("sse4.2") != 0;
+#endif // _MSC_VER
+}
+
+#else // MISO_CHECKSUM_X86
+
+MISO_INLINE uint32_t
+Checksum::UpdateCrc32cHardware(uint32_t crc, const uint8_t* data, size_t size)
+{
+    return UpdateCrc32cSoftware(crc, data, size);
+}
+
+MISO_INLINE bool
+Checksum::IsCrc32cHardwareAvailable()
+{
+    return false;
+}
+
+#endif // MISO_CHECKSUM_X86
+
+MISO_INLINE const uint32_t*
+Checksum::GetCrc32cTable()
+{
+    struct Table { uint32_t values[8 * 256]; };
+    static const Table table = [] {
+        Table t = {};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) ? ((crc >> 1) ^ kCrc32cPolynomial) : (crc >> 1);
+            }
+            t.values[i] = crc;
+        }
+        for (size_t i = 0; i < 256; ++i) {
+            for (size_t slice = 1; slice < 8; ++slice) {
+                auto previous = t.values[(slice - 1) * 256 + i];
+                t.values[slice * 256 + i] = (previous >> 8) ^ t.values[previous & 0xFF];
+            }
+        }
+        return t;
+    }();
+    return table.values;
+}
+
+MISO_INLINE const uint8_t*
+Checksum::ConsumeXxHashStripes(uint64_t* lanes, const uint8_t* data, const uint8_t* end)
+{
+    while (static_cast<size_t>(end - data) >= kXxHashStripeSize) {
+        lanes[0] = XxHashRound(lanes[0], ReadLittle64(data));
+        lanes[1] = XxHashRound(lanes[1], ReadLittle64(data + 8));
+        lanes[2] = XxHashRound(lanes[2], ReadLittle64(data + 16));
+        lanes[3] = XxHashRound(lanes[3], ReadLittle64(data + 24));
+        data += kXxHashStripeSize;
+    }
+    return data;
+}
+
+MISO_INLINE uint64_t
+Checksum::FinalizeXxHash64(const uint64_t* lanes, uint64_t seed, uint64_t total_size, const uint8_t* rest, size_t rest_size)
+{
+    uint64_t hash;
+    if (total_size >= kXxHashStripeSize) {
+        hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+        for (int i = 0; i < 4; ++i) {
+            hash = XxHashMergeRound(hash, lanes[i]);
+        }
+    } else {
+        hash = seed + kXxHashPrime5;
+    }
+    hash += total_size;
+
+    auto end = rest + rest_size;
+    while (end - rest >= 8) {
+        hash ^= XxHashRound(0, ReadLittle64(rest));
+        hash = RotateLeft(hash, 27) * kXxHashPrime1 + kXxHashPrime4;
+        rest += 8;
+    }
+    if (end - rest >= 4) {
+        hash ^= static_cast<uint64_t>(ReadLittle32(rest)) * kXxHashPrime1;
+        hash = RotateLeft(hash, 23) * kXxHashPrime2 + kXxHashPrime3;
+        rest += 4;
+    }
+    while (rest < end) {
+        hash ^= static_cast<uint64_t>(*rest++) * kXxHashPrime5;
+        hash = RotateLeft(hash, 11) * kXxHashPrime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= kXxHashPrime2;
+    hash ^= hash >> 29;
+    hash *= kXxHashPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+} // namespace miso
@@ -0,0 +1,66 @@
+#include "miso/checksum_stream.hpp"
+
+#include <algorithm>
+
+#include "miso/checksum.hpp"
+#include "miso/stream.hpp"
+
+namespace miso {
+
+MISO_INLINE
+ChecksumStream::ChecksumStream(IStream& stream, ChecksumType type, uint64_t seed) :
+    stream_(stream),
+    checksum_(type, seed)
+{}
+
+MISO_INLINE uint8_t
+ChecksumStream::Read()
+{
+    auto position = stream_.GetPosition();
+    auto one = stream_.Read();
+    if (position < stream_.GetPosition()) Update(position, &one, 1);
+    return one;
+}
+
+MISO_INLINE size_t
+ChecksumStream::ReadBlock(uint8_t* buffer, size_t size)
+{
+    size_t read_size = 0;
+    while (read_size < size) {
+        auto position = stream_.GetPosition();
+        auto slice_size = std::min(size - read_size, kSliceSize);
+        auto actual_size = stream_.ReadBlock(buffer + read_size, slice_size);
+        Update(position, buffer + read_size, actual_size);
+        read_size += actual_size;
+        if (actual_size < slice_size) break;
+    }
+    return read_size;
+}
+
+MISO_INLINE bool
+ChecksumStream::Verify(uint64_t expected_value)
+{
+    auto position = stream_.GetPosition();
+    stream_.SetPosition(GetCheckedSize());
+    if (stream_.GetPosition() != GetCheckedSize()) {
+        // The stream cannot go back to the bytes skipped before
+        stream_.SetPosition(position);
+        return false;
+    }
+    uint8_t buffer[4096];
+    while (ReadBlock(buffer, sizeof(buffer)) == sizeof(buffer)) {}
+    stream_.SetPosition(position);
+    return checksum_.GetValue() == expected_value;
+}
+
+MISO_INLINE void
+ChecksumStream::Update(size_t position, const uint8_t* data, size_t size)
+{
+    auto checked_size = GetCheckedSize();
+    if (position <= checked_size && checked_size < position + size) {
+        auto offset = checked_size - position;
+        checksum_.Update(data + offset, size - offset);
+    }
+}
+
+} // namespace miso
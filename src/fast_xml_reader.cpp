@@ -0,0 +1,490 @@
+#include "miso/fast_xml_reader.hpp"
+
+#include <cstring>
+
+#include "miso/file_stream.hpp"
+#include "miso/string_utils.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MISO_FAST_XML_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif // _MSC_VER
+#endif
+
+namespace miso {
+
+namespace {
+
+inline bool
+IsBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline bool
+IsBlank(std::string_view text)
+{
+    for (auto c : text) {
+        if (!IsBlank(c)) return false;
+    }
+    return true;
+}
+
+// Returns the first of a, b or c in [p, end), or end.
+inline const char*
+FindAny(const char* p, const char* end, char a, char b, char c)
+{
+#ifdef MISO_FAST_XML_SSE2
+    auto va = _mm_set1_epi8(a);
+    auto vb = _mm_set1_epi8(b);
+    auto vc = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        auto found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, va), _mm_cmpeq_epi8(chunk, vb)), _mm_cmpeq_epi8(chunk, vc));
+        auto mask = static_cast<unsigned int>(_mm_movemask_epi8(found));
+        if (mask != 0) {
+#ifdef _MSC_VER
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return p + index;
+#else // _MSC_VER
+            return p + __builtin_ctz(mask);
+#endif // _MSC_VER
+        }
+        p += 16;
+    }
+#endif // MISO_FAST_XML_SSE2
+    while (p < end && *p != a && *p != b && *p != c) ++p;
+    return p;
+}
+
+// Finds the end of a text or an attribute value, noting whether it contains a reference.
+inline const char*
+FindEndOfValue(const char* p, const char* end, char terminator, bool* has_reference)
+{
+    p = FindAny(p, end, terminator, '&', '&');
+    while (p < end && *p == '&') {
+        *has_reference = true;
+        p = FindAny(p + 1, end, terminator, '&', '&');
+    }
+    return p;
+}
+
+inline void
+AppendUtf8(uint32_t code, std::string& out)
+{
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+} // namespace
+
+MISO_INLINE
+FastXmlReader::FastXmlReader(const char* filename)
+{
+    FileStream stream(filename);
+    if (!stream.CanRead()) {
+        errors_.push_back("Cannot open file");
+        reached_to_end_ = true;
+        return;
+    }
+    owned_buffer_.resize(stream.GetSize());
+    auto size = stream.ReadBlock(reinterpret_cast<uint8_t*>(owned_buffer_.data()), owned_buffer_.size());
+    begin_ = owned_buffer_.data();
+    current_ = begin_;
+    end_ = begin_ + size;
+    if (end_ - current_ >= 3 && std::memcmp(current_, "\xEF\xBB\xBF", 3) == 0) current_ += 3;
+}
+
+MISO_INLINE
+FastXmlReader::FastXmlReader(const char* buffer, size_t size) :
+    begin_(buffer),
+    current_(buffer),
+    end_(buffer + size)
+{
+    if (size >= 3 && std::memcmp(current_, "\xEF\xBB\xBF", 3) == 0) current_ += 3;
+}
+
+MISO_INLINE bool
+FastXmlReader::Read()
+{
+    while (!reached_to_end_) {
+        if (current_ >= end_) {
+            if (!open_elements_.empty()) return Fail("Premature end of data");
+            reached_to_end_ = true;
+            element_name_ = std::string_view();
+            attributes_.clear();
+            break;
+        }
+
+        if (*current_ != '<') {
+            auto text_begin = current_;
+            bool has_reference = false;
+            current_ = FindEndOfValue(current_, end_, '<', &has_reference);
+            std::string_view text(text_begin, static_cast<size_t>(current_ - text_begin));
+            if (IsBlank(text)) continue;
+            if (open_elements_.empty()) return Fail("Text outside of the root element");
+            node_type_ = XmlNodeType::Text;
+            depth_ = static_cast<int>(open_elements_.size());
+            text_ = text;
+            text_has_reference_ = has_reference;
+            text_decoded_ = false;
+            return true;
+        }
+
+        if (end_ - current_ < 2) return Fail("Premature end of data");
+        if (current_[1] == '/') return ReadEndTag();
+        if (current_[1] == '!' || current_[1] == '?') {
+            if (!SkipMarkup()) return false;
+            continue;
+        }
+        return ReadStartTag();
+    }
+    return false;
+}
+
+MISO_INLINE bool
+FastXmlReader::SkipSubtree()
+{
+    if (node_type_ != XmlNodeType::StartElement) return Read();
+    return SkipToEndTag() && Read();
+}
+
+MISO_INLINE bool
+FastXmlReader::MoveToElement(const char* element_name, const char* attribute_name, const char* attribute_value)
+{
+    return MoveToElementInside(element_name, attribute_name, attribute_value, false);
+}
+
+MISO_INLINE bool
+FastXmlReader::MoveToElementInCurrentLevel(const char* element_name, const char* attribute_name, const char* attribute_value)
+{
+    return MoveToElementInside(element_name, attribute_name, attribute_value, true);
+}
+
+MISO_INLINE std::string_view
+FastXmlReader::GetElementNameView() const
+{
+    if (node_type_ == XmlNodeType::StartElement ||
+        node_type_ == XmlNodeType::EmptyElement ||
+        node_type_ == XmlNodeType::EndElement) {
+        return element_name_;
+    }
+    return std::string_view();
+}
+
+MISO_INLINE std::string_view
+FastXmlReader::GetContentTextView() const
+{
+    if (node_type_ != XmlNodeType::Text) return std::string_view();
+    if (!text_has_reference_) return text_;
+    if (!text_decoded_) {
+        DecodeReferences(text_, decoded_text_);
+        text_decoded_ = true;
+    }
+    return decoded_text_;
+}
+
+MISO_INLINE std::string_view
+FastXmlReader::GetAttributeValueView(const char* name) const
+{
+    auto attribute = FindAttribute(name);
+    if (attribute == nullptr) return std::string_view();
+    if (!attribute->has_reference) return attribute->value;
+    DecodeReferences(attribute->value, decoded_value_);
+    return decoded_value_;
+}
+
+MISO_INLINE const std::vector<XmlAttribute>
+FastXmlReader::GetAllAttributes() const
+{
+    std::vector<XmlAttribute> attributes;
+    if (node_type_ == XmlNodeType::StartElement ||
+        node_type_ == XmlNodeType::EmptyElement) {
+        std::string value;
+        for (auto& attribute : attributes_) {
+            if (attribute.has_reference) {
+                DecodeReferences(attribute.value, value);
+            } else {
+                value.assign(attribute.value.data(), attribute.value.size());
+            }
+            attributes.push_back(XmlAttribute(std::string(attribute.name), value));
+        }
+    }
+    return attributes;
+}
+
+// Decodes the predefined entities and the character references, leaving the other references as they are.
+MISO_INLINE void
+FastXmlReader::DecodeReferences(std::string_view raw, std::string& decoded)
+{
+    decoded.clear();
+    size_t position = 0;
+    while (position < raw.size()) {
+        auto ampersand = raw.find('&', position);
+        auto semicolon = (ampersand != std::string_view::npos) ? raw.find(';', ampersand) : std::string_view::npos;
+        if (semicolon == std::string_view::npos) break;
+        decoded.append(raw.data() + position, ampersand - position);
+        position = semicolon + 1;
+
+        auto name = raw.substr(ampersand + 1, semicolon - ampersand - 1);
+        if (name == "lt") {
+            decoded += '<';
+        } else if (name == "gt") {
+            decoded += '>';
+        } else if (name == "amp") {
+            decoded += '&';
+        } else if (name == "quot") {
+            decoded += '"';
+        } else if (name == "apos") {
+            decoded += '\'';
+        } else if (name.size() >= 2 && name[0] == '#') {
+            bool hex = (name[1] == 'x');
+            uint32_t code = 0;
+            for (auto c : name.substr(hex ? 2 : 1)) {
+                uint32_t digit;
+                if ('0' <= c && c <= '9') {
+                    digit = static_cast<uint32_t>(c - '0');
+                } else if (hex && 'a' <= (c | 0x20) && (c | 0x20) <= 'f') {
+                    digit = static_cast<uint32_t>((c | 0x20) - 'a' + 10);
+                } else {
+                    break;
+                }
+                code = code * (hex ? 16 : 10) + digit;
+            }
+            AppendUtf8(code, decoded);
+        } else {
+            decoded.append(raw.data() + ampersand, position - ampersand);
+        }
+    }
+    if (position < raw.size()) decoded.append(raw.data() + position, raw.size() - position);
+}
+
+MISO_INLINE bool
+FastXmlReader::ReadStartTag()
+{
+    auto p = current_ + 1;
+    auto name_begin = p;
+    while (p < end_ && !IsBlank(*p) && *p != '/' && *p != '>') ++p;
+    if (p == name_begin) return Fail("Element name expected");
+    element_name_ = std::string_view(name_begin, static_cast<size_t>(p - name_begin));
+
+    attributes_.clear();
+    bool empty_element = false;
+    while (true) {
+        while (p < end_ && IsBlank(*p)) ++p;
+        if (p >= end_) return Fail("Premature end of data");
+        if (*p == '>') {
+            ++p;
+            break;
+        }
+        if (*p == '/') {
+            if (end_ - p < 2 || p[1] != '>') return Fail("'>' expected");
+            p += 2;
+            empty_element = true;
+            break;
+        }
+
+        RawAttribute attribute;
+        auto attribute_name_begin = p;
+        while (p < end_ && !IsBlank(*p) && *p != '=' && *p != '/' && *p != '>') ++p;
+        attribute.name = std::string_view(attribute_name_begin, static_cast<size_t>(p - attribute_name_begin));
+        while (p < end_ && IsBlank(*p)) ++p;
+        if (p >= end_ || *p != '=') return Fail("'=' expected");
+        ++p;
+        while (p < end_ && IsBlank(*p)) ++p;
+        if (p >= end_ || (*p != '"' && *p != '\'')) return Fail("Quoted value expected");
+        auto quote = *p++;
+        auto value_begin = p;
+        p = FindEndOfValue(p, end_, quote, &attribute.has_reference);
+        if (p >= end_) return Fail("Premature end of data");
+        attribute.value = std::string_view(value_begin, static_cast<size_t>(p - value_begin));
+        ++p;
+        attributes_.push_back(attribute);
+    }
+
+    current_ = p;
+    depth_ = static_cast<int>(open_elements_.size());
+    if (empty_element) {
+        node_type_ = XmlNodeType::EmptyElement;
+    } else {
+        node_type_ = XmlNodeType::StartElement;
+        open_elements_.push_back(element_name_);
+    }
+    return true;
+}
+
+MISO_INLINE bool
+FastXmlReader::ReadEndTag()
+{
+    auto p = current_ + 2;
+    auto name_begin = p;
+    while (p < end_ && !IsBlank(*p) && *p != '>') ++p;
+    std::string_view name(name_begin, static_cast<size_t>(p - name_begin));
+    while (p < end_ && IsBlank(*p)) ++p;
+    if (p >= end_) return Fail("Premature end of data");
+    if (*p != '>') return Fail("'>' expected");
+    if (open_elements_.empty() || open_elements_.back() != name) {
+        return Fail(StringUtils::Format("Opening and ending tag mismatch: %s", std::string(name).c_str()).c_str());
+    }
+
+    open_elements_.pop_back();
+    current_ = p + 1;
+    element_name_ = name;
+    attributes_.clear();
+    depth_ = static_cast<int>(open_elements_.size());
+    node_type_ = XmlNodeType::EndElement;
+    return true;
+}
+
+// Skips a comment, a processing instruction, a CDATA section or a document type declaration.
+MISO_INLINE bool
+FastXmlReader::SkipMarkup()
+{
+    std::string_view rest(current_, static_cast<size_t>(end_ - current_));
+    size_t end_position = std::string_view::npos;
+    if (rest.compare(0, 4, "<!--") == 0) {
+        end_position = rest.find("-->", 4);
+        if (end_position != std::string_view::npos) end_position += 3;
+    } else if (rest.compare(0, 9, "<![CDATA[") == 0) {
+        end_position = rest.find("]]>", 9);
+        if (end_position != std::string_view::npos) end_position += 3;
+    } else if (rest[1] == '?') {
+        end_position = rest.find("?>", 2);
+        if (end_position != std::string_view::npos) end_position += 2;
+    } else {
+        // '>' outside of the internal subset
+        int bracket_depth = 0;
+        for (size_t i = 2; i < rest.size(); ++i) {
+            if (rest[i] == '[') {
+                ++bracket_depth;
+            } else if (rest[i] == ']') {
+                --bracket_depth;
+            } else if (rest[i] == '>' && bracket_depth <= 0) {
+                end_position = i + 1;
+                break;
+            }
+        }
+    }
+    if (end_position == std::string_view::npos) return Fail("Premature end of data");
+    current_ += end_position;
+    return true;
+}
+
+// Scans to the end tag of the current start element looking only at the markup delimiters, then reads the end tag.
+MISO_INLINE bool
+FastXmlReader::SkipToEndTag()
+{
+    size_t open_count = 1;
+    auto p = current_;
+    while (true) {
+        p = FindAny(p, end_, '<', '<', '<');
+        if (end_ - p < 2) return Fail("Premature end of data");
+        if (p[1] == '/') {
+            if (--open_count == 0) break;
+            p += 2;
+            continue;
+        }
+        if (p[1] == '!' || p[1] == '?') {
+            current_ = p;
+            if (!SkipMarkup()) return false;
+            p = current_;
+            continue;
+        }
+        // A quoted attribute value can contain '>'.
+        ++p;
+        while (true) {
+            p = FindAny(p, end_, '>', '"', '\'');
+            if (p >= end_) return Fail("Premature end of data");
+            if (*p == '>') break;
+            p = FindAny(p + 1, end_, *p, *p, *p);
+            if (p >= end_) return Fail("Premature end of data");
+            ++p;
+        }
+        if (p[-1] != '/') ++open_count;
+        ++p;
+    }
+    current_ = p;
+    return ReadEndTag();
+}
+
+MISO_INLINE bool
+FastXmlReader::MoveToElementInside(const char* element_name, const char* attribute_name, const char* attribute_value, bool only_current_level)
+{
+    int level = depth_;
+    bool moved = only_current_level ? SkipSubtree() : Read();
+    while (moved) {
+        if (node_type_ == XmlNodeType::StartElement || node_type_ == XmlNodeType::EmptyElement) {
+            bool found = (!only_current_level || depth_ == level) &&
+                (element_name == nullptr || element_name_ == element_name);
+            if (found && attribute_name != nullptr) {
+                auto value = GetAttributeValueView(attribute_name);
+                found = value.data() != nullptr && (attribute_value == nullptr || value == attribute_value);
+            }
+            if (found) return true;
+            moved = only_current_level ? SkipSubtree() : Read();
+        } else if (node_type_ == XmlNodeType::EndElement && only_current_level && depth_ < level) {
+            return false;
+        } else {
+            moved = Read();
+        }
+    }
+    return false;
+}
+
+MISO_INLINE bool
+FastXmlReader::MoveToEndElementInside(bool end_of_parent)
+{
+    int depth = end_of_parent ? depth_ - 1 : depth_;
+    if (node_type_ == XmlNodeType::StartElement) {
+        if (!SkipToEndTag()) return false;
+        if (!end_of_parent) return true;
+    } else if (!end_of_parent) {
+        return false;
+    }
+
+    // Every child element is skipped with its subtree.
+    while (Read()) {
+        if (node_type_ == XmlNodeType::EndElement && depth_ == depth) return true;
+        if (node_type_ == XmlNodeType::StartElement && !SkipToEndTag()) return false;
+    }
+    return false;
+}
+
+MISO_INLINE const FastXmlReader::RawAttribute*
+FastXmlReader::FindAttribute(std::string_view name) const
+{
+    if (node_type_ != XmlNodeType::StartElement && node_type_ != XmlNodeType::EmptyElement) return nullptr;
+    for (auto& attribute : attributes_) {
+        if (attribute.name == name) return &attribute;
+    }
+    return nullptr;
+}
+
+MISO_INLINE bool
+FastXmlReader::Fail(const char* message)
+{
+    errors_.push_back(StringUtils::Format("[ERROR] %s", message));
+    reached_to_end_ = true;
+    current_ = end_;
+    element_name_ = std::string_view();
+    attributes_.clear();
+    return false;
+}
+
+} // namespace miso
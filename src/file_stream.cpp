@@ -52,6 +52,7 @@ MISO_INLINE uint8_t
 FileStream::Read()
 {
     auto one = *current_++;
+    MISO_STREAM_STATS_ONLY(++stats_.delivered_bytes;)
     FillBuffer();
     return one;
 }
@@ -60,26 +61,32 @@ MISO_INLINE size_t
 FileStream::ReadBlock(uint8_t* buffer, size_t size)
 {
     size_t remain = size;
-    do {
+    while (0 < remain) {
         size_t copy_size = remain;
         size_t current_to_end = static_cast<size_t>(end_ - current_);
         if (current_to_end < copy_size) { copy_size = current_to_end; }
-        memcpy(buffer, current_, copy_size);
+        if (copy_size == 0) break;
+        memcpy(buffer + (size - remain), current_, copy_size);
         current_ += copy_size;
         FillBuffer();
         remain -= copy_size;
-    } while (0 < remain && !reached_to_end_);
+    }
+    MISO_STREAM_STATS_ONLY(stats_.delivered_bytes += size - remain;)
     return size - remain;
 }
 
 MISO_INLINE void
 FileStream::SetPosition(size_t position)
 {
+    MISO_STREAM_STATS_ONLY(++stats_.seek_count;)
     if (offset_ <= position && position <= kBufferSize) {
         current_ = begin_ + (position - offset_);
     } else {
         reached_to_end_ = false;
-        fseek(fp_, static_cast<long>(position), SEEK_SET);
+        {
+            MISO_STREAM_STATS_ONLY(++stats_.syscall_count; StreamStats::Timer timer(stats_);)
+            fseek(fp_, static_cast<long>(position), SEEK_SET);
+        }
         offset_ = position;
         end_ = nullptr;
         FillBuffer();
@@ -101,7 +108,9 @@ MISO_INLINE void
 FileStream::FillBuffer()
 {
     if (current_ < end_ || reached_to_end_) return;
+    MISO_STREAM_STATS_ONLY(StreamStats::Timer timer(stats_);)
     size_t read_count = fread(buffer_, 1, kBufferSize, fp_);
+    MISO_STREAM_STATS_ONLY(++stats_.refill_count; ++stats_.syscall_count; stats_.os_read_bytes += read_count;)
     if (end_ != nullptr) offset_ += kBufferSize;
     current_ = buffer_;
     end_ = buffer_ + read_count;
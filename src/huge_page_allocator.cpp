@@ -0,0 +1,84 @@
+#include "miso/huge_page_allocator.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#else
+#include <cstdlib>
+#endif
+
+namespace miso {
+
+#if defined(_WIN32)
+
+MISO_INLINE void*
+HugePageUtils::Allocate(size_t size)
+{
+    // MEM_LARGE_PAGES requires SeLockMemoryPrivilege, so it fails on most accounts.
+    auto large_page_size = ::GetLargePageMinimum();
+    if (large_page_size != 0) {
+        auto large_size = (size + large_page_size - 1) / large_page_size * large_page_size;
+        auto pointer = ::VirtualAlloc(nullptr, large_size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (pointer != nullptr) return pointer;
+    }
+    return ::VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+MISO_INLINE void
+HugePageUtils::Deallocate(void* pointer, size_t size)
+{
+    (void)size;
+    if (pointer != nullptr) ::VirtualFree(pointer, 0, MEM_RELEASE);
+}
+
+#elif defined(__linux__)
+
+MISO_INLINE void*
+HugePageUtils::Allocate(size_t size)
+{
+    // mmap only guarantees normal page alignment, so map one extra huge page and trim both ends.
+    auto allocation_size = GetAllocationSize(size);
+    auto map_size = allocation_size + kHugePageSize;
+    auto map = ::mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) return nullptr;
+
+    auto map_begin = reinterpret_cast<uintptr_t>(map);
+    auto aligned_begin = (map_begin + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+    auto head_size = aligned_begin - map_begin;
+    auto tail_size = map_size - head_size - allocation_size;
+    if (head_size > 0) ::munmap(map, head_size);
+    if (tail_size > 0) ::munmap(reinterpret_cast<void*>(aligned_begin + allocation_size), tail_size);
+
+    auto pointer = reinterpret_cast<void*>(aligned_begin);
+#ifdef MADV_HUGEPAGE
+    // Fails if transparent huge pages are disabled; the region stays on normal pages then.
+    (void)::madvise(pointer, allocation_size, MADV_HUGEPAGE);
+#endif // MADV_HUGEPAGE
+    return pointer;
+}
+
+MISO_INLINE void
+HugePageUtils::Deallocate(void* pointer, size_t size)
+{
+    if (pointer != nullptr) ::munmap(pointer, GetAllocationSize(size));
+}
+
+#else
+
+MISO_INLINE void*
+HugePageUtils::Allocate(size_t size)
+{
+    return std::malloc(size);
+}
+
+MISO_INLINE void
+HugePageUtils::Deallocate(void* pointer, size_t size)
+{
+    (void)size;
+    std::free(pointer);
+}
+
+#endif
+
+} // namespace miso
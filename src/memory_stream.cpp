@@ -6,6 +6,23 @@
 
 namespace miso {
 
+MISO_INLINE void
+MemoryStream::SetPosition(size_t position)
+{
+    MISO_STREAM_STATS_ONLY(++stats_.seek_count;)
+    current_ = ((begin_ + position) < end_) ? (begin_ + position) : end_;
+}
+
+MISO_INLINE uint8_t
+MemoryStream::Read()
+{
+    if (current_ < end_) {
+        MISO_STREAM_STATS_ONLY(++stats_.delivered_bytes;)
+        return *current_++;
+    }
+    return *(end_ - 1);
+}
+
 MISO_INLINE size_t
 MemoryStream::ReadBlock(uint8_t* buffer, size_t size)
 {
@@ -15,6 +32,7 @@ MemoryStream::ReadBlock(uint8_t* buffer, size_t size)
         actual_size = (size < remain) ? size : remain;
         std::memcpy(buffer, current_, actual_size);
         current_ += actual_size;
+        MISO_STREAM_STATS_ONLY(stats_.delivered_bytes += actual_size;)
     }
     return actual_size;
 }
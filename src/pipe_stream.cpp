@@ -0,0 +1,147 @@
+#include "miso/pipe_stream.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "miso/stream.hpp"
+
+namespace miso {
+
+MISO_INLINE
+PipeStream::PipeStream(PipeStream&& other) noexcept :
+    fd_(other.fd_),
+    owns_fd_(other.owns_fd_),
+    rewind_size_(other.rewind_size_),
+    position_(other.position_),
+    buffer_(std::move(other.buffer_)),
+    begin_position_(other.begin_position_),
+    end_position_(other.end_position_),
+    reached_to_end_(other.reached_to_end_)
+{
+    other.fd_ = -1;
+    other.owns_fd_ = false;
+}
+
+MISO_INLINE
+PipeStream::PipeStream(int fd, size_t rewind_size, bool owns_fd) :
+    fd_(fd),
+    owns_fd_(owns_fd),
+    rewind_size_(rewind_size),
+    position_(0),
+    buffer_(rewind_size + kReadSize),
+    begin_position_(0),
+    end_position_(0),
+    reached_to_end_(fd < 0)
+{}
+
+MISO_INLINE
+PipeStream::~PipeStream()
+{
+    if (owns_fd_ && fd_ >= 0) {
+#ifdef _WIN32
+        _close(fd_);
+#else
+        close(fd_);
+#endif
+    }
+}
+
+MISO_INLINE bool
+PipeStream::CanRead(size_t size) const
+{
+    return FillBuffer(size);
+}
+
+MISO_INLINE uint8_t
+PipeStream::Read()
+{
+    if (!FillBuffer(1)) return 0;
+    MISO_STREAM_STATS_ONLY(++stats_.delivered_bytes;)
+    return *GetPointer(position_++);
+}
+
+MISO_INLINE uint8_t
+PipeStream::Peek() const
+{
+    if (!FillBuffer(1)) return 0;
+    return *GetPointer(position_);
+}
+
+MISO_INLINE size_t
+PipeStream::ReadBlock(uint8_t* buffer, size_t size)
+{
+    size_t read_size = 0;
+    while (read_size < size) {
+        if (position_ == end_position_ && !FillBuffer(1)) break;
+        size_t copy_size = std::min(end_position_ - position_, size - read_size);
+        size_t offset = position_ % buffer_.size();
+        copy_size = std::min(copy_size, buffer_.size() - offset);
+        std::memcpy(buffer + read_size, GetPointer(position_), copy_size);
+        position_ += copy_size;
+        read_size += copy_size;
+    }
+    MISO_STREAM_STATS_ONLY(stats_.delivered_bytes += read_size;)
+    return read_size;
+}
+
+MISO_INLINE void
+PipeStream::SetPosition(size_t position)
+{
+    MISO_STREAM_STATS_ONLY(++stats_.seek_count;)
+    if (position < begin_position_) {
+        position_ = begin_position_;
+    } else if (position <= end_position_) {
+        position_ = position;
+    } else {
+        // Seeking forward is done by consuming the stream.
+        position_ = end_position_;
+        while (position_ < position && FillBuffer(1)) {
+            position_ = std::min(position, end_position_);
+        }
+    }
+}
+
+// Makes at least 'size' bytes from the current position available in the buffer, if the stream has them.
+// Requests larger than the buffer can not be satisfied.
+MISO_INLINE bool
+PipeStream::FillBuffer(size_t size) const
+{
+    auto capacity = buffer_.size();
+    while ((end_position_ - position_) < size && !reached_to_end_) {
+        auto keep_from = (position_ > rewind_size_) ? (position_ - rewind_size_) : 0;
+        if (begin_position_ < keep_from) begin_position_ = keep_from;
+        auto free_size = capacity - (end_position_ - begin_position_);
+        if (free_size == 0) {
+            // Give up the rewind window to look further ahead.
+            if (begin_position_ == position_) break;
+            begin_position_ += std::min(position_ - begin_position_, kReadSize);
+            continue;
+        }
+        auto offset = end_position_ % capacity;
+        auto request_size = std::min(free_size, capacity - offset);
+        MISO_STREAM_STATS_ONLY(++stats_.refill_count; ++stats_.syscall_count; StreamStats::Timer timer(stats_);)
+#ifdef _WIN32
+        auto read_size = _read(fd_, GetPointer(end_position_), static_cast<unsigned int>(request_size));
+#else
+        auto read_size = read(fd_, GetPointer(end_position_), request_size);
+#endif
+        if (read_size < 0 && errno == EINTR) continue;
+        if (read_size <= 0) {
+            reached_to_end_ = true;
+            break;
+        }
+        end_position_ += static_cast<size_t>(read_size);
+        MISO_STREAM_STATS_ONLY(stats_.os_read_bytes += static_cast<size_t>(read_size);)
+    }
+    return size <= (end_position_ - position_);
+}
+
+} // namespace miso
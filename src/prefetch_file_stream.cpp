@@ -0,0 +1,173 @@
+#include "miso/prefetch_file_stream.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace miso {
+
+MISO_INLINE
+PrefetchFileStream::PrefetchFileStream(const char* filename, size_t chunk_size, size_t chunk_count) :
+    fp_(fopen(filename, "rb")),
+    chunks_(std::max<size_t>(chunk_count, 1))
+{
+    if (fp_ != nullptr) {
+        fseek(fp_, 0, SEEK_END);
+        auto end = ftell(fp_);
+        stream_size_ = (end != -1L) ? static_cast<size_t>(end) : 0;
+    }
+    for (auto& chunk : chunks_) {
+        chunk.data.resize(std::max<size_t>(chunk_size, 1));
+    }
+    Start(0);
+}
+
+MISO_INLINE
+PrefetchFileStream::~PrefetchFileStream()
+{
+    Stop();
+    if (fp_ != nullptr) fclose(fp_);
+}
+
+MISO_INLINE bool
+PrefetchFileStream::CanRead(size_t size) const
+{
+    return fp_ != nullptr && GetPosition() + size <= stream_size_;
+}
+
+MISO_INLINE uint8_t
+PrefetchFileStream::Read()
+{
+    if (!EnsureData()) return 0;
+    MISO_STREAM_STATS_ONLY(++stats_.delivered_bytes;)
+    return current_->data[offset_++];
+}
+
+MISO_INLINE uint8_t
+PrefetchFileStream::Peek() const
+{
+    return EnsureData() ? current_->data[offset_] : 0;
+}
+
+MISO_INLINE size_t
+PrefetchFileStream::ReadBlock(uint8_t* buffer, size_t size)
+{
+    size_t read_size = 0;
+    while (read_size < size && EnsureData()) {
+        auto copy_size = std::min(current_->size - offset_, size - read_size);
+        std::memcpy(buffer + read_size, current_->data.data() + offset_, copy_size);
+        offset_ += copy_size;
+        read_size += copy_size;
+    }
+    MISO_STREAM_STATS_ONLY(stats_.delivered_bytes += read_size;)
+    return read_size;
+}
+
+MISO_INLINE void
+PrefetchFileStream::SetPosition(size_t position)
+{
+    MISO_STREAM_STATS_ONLY(++stats_.seek_count;)
+    position = std::min(position, stream_size_);
+    if (current_ != nullptr && chunk_position_ <= position && position <= chunk_position_ + current_->size) {
+        offset_ = position - chunk_position_;
+        return;
+    }
+    Stop();
+    Start(position);
+}
+
+MISO_INLINE void
+PrefetchFileStream::Start(size_t position)
+{
+    stop_requested_ = false;
+    produced_all_ = (fp_ == nullptr);
+    filled_count_ = 0;
+    released_count_ = 0;
+    current_ = nullptr;
+    chunk_position_ = position;
+    offset_ = 0;
+    if (fp_ != nullptr) thread_ = std::thread(&PrefetchFileStream::Produce, this, position);
+}
+
+MISO_INLINE void
+PrefetchFileStream::Stop()
+{
+    stop_requested_ = true;
+    Notify();
+    if (thread_.joinable()) thread_.join();
+}
+
+// Runs on the background thread, filling the chunks not held by the consumer.
+MISO_INLINE void
+PrefetchFileStream::Produce(size_t position)
+{
+    fseek(fp_, static_cast<long>(position), SEEK_SET);
+    auto capacity = chunks_.size();
+    size_t filled_count = 0;
+    while (!stop_requested_.load(std::memory_order_relaxed)) {
+        if (filled_count - released_count_.load(std::memory_order_acquire) == capacity) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this, filled_count, capacity] {
+                return stop_requested_.load(std::memory_order_relaxed) ||
+                    filled_count - released_count_.load(std::memory_order_acquire) < capacity;
+            });
+            continue;
+        }
+        auto& chunk = chunks_[filled_count % capacity];
+        chunk.size = fread(chunk.data.data(), 1, chunk.data.size(), fp_);
+        if (chunk.size > 0) {
+            filled_count_.store(++filled_count, std::memory_order_release);
+            Notify();
+        }
+        if (chunk.size < chunk.data.size()) break;
+    }
+    produced_all_.store(true, std::memory_order_release);
+    Notify();
+}
+
+// The state is changed before locking, so a thread checking it under the lock does not miss the notification.
+MISO_INLINE void
+PrefetchFileStream::Notify() const
+{
+    { std::lock_guard<std::mutex> lock(mutex_); }
+    condition_.notify_all();
+}
+
+MISO_INLINE bool
+PrefetchFileStream::EnsureData() const
+{
+    while (current_ == nullptr || offset_ >= current_->size) {
+        if (!AcquireChunk()) return false;
+    }
+    return true;
+}
+
+// Gives the current chunk back to the producer and waits for the next one.
+MISO_INLINE bool
+PrefetchFileStream::AcquireChunk() const
+{
+    auto released_count = released_count_.load(std::memory_order_relaxed);
+    if (current_ != nullptr) {
+        chunk_position_ += current_->size;
+        offset_ = 0;
+        current_ = nullptr;
+        released_count_.store(++released_count, std::memory_order_release);
+        Notify();
+    }
+
+    auto available = [this, released_count] {
+        return filled_count_.load(std::memory_order_acquire) != released_count;
+    };
+    if (!available()) {
+        MISO_STREAM_STATS_ONLY(StreamStats::Timer timer(stats_);)
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait(lock, [this, &available] {
+            return available() || produced_all_.load(std::memory_order_acquire);
+        });
+    }
+    if (!available()) return false;
+    current_ = &chunks_[released_count % chunks_.size()];
+    MISO_STREAM_STATS_ONLY(++stats_.refill_count; ++stats_.syscall_count; stats_.os_read_bytes += current_->size;)
+    return true;
+}
+
+} // namespace miso
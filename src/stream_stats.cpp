@@ -0,0 +1,80 @@
+#include "miso/stream_stats.hpp"
+
+#include <atomic>
+
+namespace miso {
+
+struct StreamStats::Global {
+    std::atomic<uint64_t> delivered_bytes{ 0 };
+    std::atomic<uint64_t> os_read_bytes{ 0 };
+    std::atomic<uint64_t> refill_count{ 0 };
+    std::atomic<uint64_t> seek_count{ 0 };
+    std::atomic<uint64_t> syscall_count{ 0 };
+    std::atomic<uint64_t> blocked_nanoseconds{ 0 };
+};
+
+MISO_INLINE StreamStats::Global&
+StreamStats::GetGlobalStorage()
+{
+    static Global global;
+    return global;
+}
+
+MISO_INLINE StreamStats
+StreamStats::GetGlobal()
+{
+    auto& global = GetGlobalStorage();
+    StreamStats stats;
+    stats.delivered_bytes = global.delivered_bytes.load(std::memory_order_relaxed);
+    stats.os_read_bytes = global.os_read_bytes.load(std::memory_order_relaxed);
+    stats.refill_count = global.refill_count.load(std::memory_order_relaxed);
+    stats.seek_count = global.seek_count.load(std::memory_order_relaxed);
+    stats.syscall_count = global.syscall_count.load(std::memory_order_relaxed);
+    stats.blocked_nanoseconds = global.blocked_nanoseconds.load(std::memory_order_relaxed);
+    return stats;
+}
+
+MISO_INLINE void
+StreamStats::ResetGlobal()
+{
+    auto& global = GetGlobalStorage();
+    global.delivered_bytes.store(0, std::memory_order_relaxed);
+    global.os_read_bytes.store(0, std::memory_order_relaxed);
+    global.refill_count.store(0, std::memory_order_relaxed);
+    global.seek_count.store(0, std::memory_order_relaxed);
+    global.syscall_count.store(0, std::memory_order_relaxed);
+    global.blocked_nanoseconds.store(0, std::memory_order_relaxed);
+}
+
+MISO_INLINE void
+StreamStats::AddGlobal(const StreamStats& stats)
+{
+    auto& global = GetGlobalStorage();
+    global.delivered_bytes.fetch_add(stats.delivered_bytes, std::memory_order_relaxed);
+    global.os_read_bytes.fetch_add(stats.os_read_bytes, std::memory_order_relaxed);
+    global.refill_count.fetch_add(stats.refill_count, std::memory_order_relaxed);
+    global.seek_count.fetch_add(stats.seek_count, std::memory_order_relaxed);
+    global.syscall_count.fetch_add(stats.syscall_count, std::memory_order_relaxed);
+    global.blocked_nanoseconds.fetch_add(stats.blocked_nanoseconds, std::memory_order_relaxed);
+}
+
+MISO_INLINE const StreamStats&
+StreamStats::GetEmpty()
+{
+    static const StreamStats empty;
+    return empty;
+}
+
+MISO_INLINE StreamStats&
+StreamStats::operator+=(const StreamStats& other)
+{
+    delivered_bytes += other.delivered_bytes;
+    os_read_bytes += other.os_read_bytes;
+    refill_count += other.refill_count;
+    seek_count += other.seek_count;
+    syscall_count += other.syscall_count;
+    blocked_nanoseconds += other.blocked_nanoseconds;
+    return *this;
+}
+
+} // namespace miso
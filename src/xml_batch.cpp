@@ -0,0 +1,122 @@
+#include "miso/xml_batch.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+
+namespace miso {
+
+MISO_INLINE void
+XmlBatch::AddFile(const char* filename)
+{
+    Document document;
+    document.filename = filename;
+    documents_.push_back(std::move(document));
+}
+
+MISO_INLINE void
+XmlBatch::AddBuffer(const char* buffer, size_t size)
+{
+    Document document;
+    document.buffer = buffer;
+    document.size = size;
+    documents_.push_back(std::move(document));
+}
+
+MISO_INLINE void
+XmlBatch::AddStream(IStream& stream)
+{
+    Document document;
+    document.stream = &stream;
+    documents_.push_back(std::move(document));
+}
+
+MISO_INLINE bool
+XmlBatch::Run(IXmlBatchVisitor& visitor, size_t thread_count)
+{
+    if (thread_count == 0) thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    thread_count = std::max<size_t>(std::min(thread_count, documents_.size()), 1);
+    errors_.assign(documents_.size(), std::vector<std::string>());
+
+    // Neighboring documents are given to the same worker.
+    workers_.clear();
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back();
+        auto begin = documents_.size() * i / thread_count;
+        auto end = documents_.size() * (i + 1) / thread_count;
+        for (auto index = begin; index < end; ++index) workers_.back().indices.push_back(index);
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back(&XmlBatch::Work, this, i, std::ref(visitor));
+    }
+    Work(0, visitor);
+    for (auto& thread : threads) thread.join();
+    workers_.clear();
+    return !HasError();
+}
+
+MISO_INLINE bool
+XmlBatch::HasError() const
+{
+    for (auto& errors : errors_) {
+        if (!errors.empty()) return true;
+    }
+    return false;
+}
+
+MISO_INLINE void
+XmlBatch::Work(size_t worker_index, IXmlBatchVisitor& visitor)
+{
+    std::unique_ptr<XmlReader> reader;
+    size_t index;
+    while (TakeDocument(worker_index, &index)) {
+        auto& document = documents_[index];
+        if (reader != nullptr) {
+            if (document.stream != nullptr) {
+                reader->Reset(*document.stream);
+            } else if (document.buffer != nullptr) {
+                reader->Reset(document.buffer, document.size);
+            } else {
+                reader->Reset(document.filename.c_str());
+            }
+        } else if (document.stream != nullptr) {
+            reader = std::make_unique<XmlReader>(*document.stream);
+        } else if (document.buffer != nullptr) {
+            reader = std::make_unique<XmlReader>(document.buffer, document.size);
+        } else {
+            reader = std::make_unique<XmlReader>(document.filename.c_str());
+        }
+        if (reader->CanRead()) visitor.OnDocument(index, *reader);
+        errors_[index] = reader->GetErrors();
+    }
+}
+
+// Takes the next document of the worker, or one from the end of another worker's queue.
+MISO_INLINE bool
+XmlBatch::TakeDocument(size_t worker_index, size_t* index_out)
+{
+    {
+        auto& worker = workers_[worker_index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.indices.empty()) {
+            *index_out = worker.indices.front();
+            worker.indices.pop_front();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        auto& victim = workers_[(worker_index + i) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.indices.empty()) {
+            *index_out = victim.indices.back();
+            victim.indices.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace miso
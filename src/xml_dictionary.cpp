@@ -0,0 +1,31 @@
+#include "miso/xml_dictionary.hpp"
+
+namespace miso {
+
+MISO_INLINE
+XmlDictionary::XmlDictionary(std::initializer_list<std::string_view> names)
+{
+    XmlReader::InitializeParser();
+    dict_ = libxml::xmlDictCreate();
+    if (dict_ == nullptr) return;
+    for (auto name : names) {
+        libxml::xmlDictLookup(dict_, reinterpret_cast<const libxml::xmlChar*>(name.data()), static_cast<int>(name.size()));
+    }
+}
+
+// The parsers still using the dictionary keep it alive by their references.
+MISO_INLINE
+XmlDictionary::~XmlDictionary()
+{
+    libxml::xmlDictFree(dict_);
+}
+
+MISO_INLINE std::string_view
+XmlDictionary::Find(std::string_view name) const
+{
+    if (dict_ == nullptr || name.data() == nullptr) return std::string_view();
+    auto found = libxml::xmlDictExists(dict_, reinterpret_cast<const libxml::xmlChar*>(name.data()), static_cast<int>(name.size()));
+    return (found != nullptr) ? std::string_view(reinterpret_cast<const char*>(found), name.size()) : std::string_view();
+}
+
+} // namespace miso
@@ -0,0 +1,379 @@
+#include "miso/xml_element_index.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace miso {
+
+namespace {
+
+bool
+IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool
+StartsWith(const char* p, const char* end, const char* prefix)
+{
+    auto length = std::strlen(prefix);
+    return static_cast<size_t>(end - p) >= length && std::memcmp(p, prefix, length) == 0;
+}
+
+const char*
+FindSequence(const char* p, const char* end, const char* sequence)
+{
+    return std::search(p, end, sequence, sequence + std::strlen(sequence));
+}
+
+// Returns the position of the '>' closing the markup, skipping quoted values and an internal subset in brackets.
+const char*
+FindEndOfMarkup(const char* p, const char* end)
+{
+    int bracket_depth = 0;
+    for (; p < end; ++p) {
+        auto c = *p;
+        if (c == '"' || c == '\'') {
+            p = std::find(p + 1, end, c);
+            if (p == end) break;
+        } else if (c == '[') {
+            ++bracket_depth;
+        } else if (c == ']') {
+            --bracket_depth;
+        } else if (c == '>' && bracket_depth <= 0) {
+            return p;
+        }
+    }
+    return end;
+}
+
+enum class MarkupType { None, StartTag, EmptyTag, EndTag, Other };
+
+// Finds the next markup from p and the position following it, returning None at the end or on malformed markup.
+// Comments, CDATA sections, processing instructions and the document type declaration are of Other.
+MarkupType
+FindNextMarkup(const char* p, const char* end, const char** begin_out, const char** next_out)
+{
+    p = static_cast<const char*>(std::memchr(p, '<', static_cast<size_t>(end - p)));
+    if (p == nullptr || end - p < 2) return MarkupType::None;
+    *begin_out = p;
+
+    const char* markup_end;
+    if (StartsWith(p, end, "<!--")) {
+        markup_end = FindSequence(p + 4, end, "-->");
+        *next_out = markup_end + 3;
+    } else if (StartsWith(p, end, "<![CDATA[")) {
+        markup_end = FindSequence(p + 9, end, "]]>");
+        *next_out = markup_end + 3;
+    } else if (p[1] == '?') {
+        markup_end = FindSequence(p + 2, end, "?>");
+        *next_out = markup_end + 2;
+    } else {
+        markup_end = FindEndOfMarkup(p + 1, end);
+        *next_out = markup_end + 1;
+        if (markup_end != end) {
+            if (p[1] == '/') return MarkupType::EndTag;
+            if (p[1] != '!') return (markup_end[-1] == '/') ? MarkupType::EmptyTag : MarkupType::StartTag;
+        }
+    }
+    return (markup_end != end) ? MarkupType::Other : MarkupType::None;
+}
+
+const char*
+FindEndOfName(const char* p, const char* end)
+{
+    while (p < end && !IsSpace(*p) && *p != '/' && *p != '>') ++p;
+    return p;
+}
+
+struct TagAttribute {
+    std::string_view name;
+    std::string_view value;
+    // The attribute as written, from the name to the closing quote
+    std::string_view text;
+};
+
+// Reads the attribute of a start tag at p, between the end of the element name and the '>', and moves p past it.
+// Returns false if there are no more attributes.
+bool
+ReadAttribute(const char*& p, const char* end, TagAttribute* attribute)
+{
+    while (p < end && IsSpace(*p)) ++p;
+    auto name_begin = p;
+    while (p < end && *p != '=' && !IsSpace(*p)) ++p;
+    auto name_end = p;
+    while (p < end && IsSpace(*p)) ++p;
+    if (p == end || *p != '=') return false;
+    ++p;
+    while (p < end && IsSpace(*p)) ++p;
+    if (p == end || (*p != '"' && *p != '\'')) return false;
+    auto quote = *p++;
+    auto value_begin = p;
+    p = std::find(p, end, quote);
+    if (p == end) return false;
+    ++p;
+    attribute->name = std::string_view(name_begin, static_cast<size_t>(name_end - name_begin));
+    attribute->value = std::string_view(value_begin, static_cast<size_t>(p - 1 - value_begin));
+    attribute->text = std::string_view(name_begin, static_cast<size_t>(p - name_begin));
+    return true;
+}
+
+// Finds the value of the attribute in a start tag, from the end of the element name to the '>'.
+std::string_view
+FindAttributeValue(const char* p, const char* end, std::string_view name)
+{
+    TagAttribute attribute;
+    while (ReadAttribute(p, end, &attribute)) {
+        if (attribute.name == name) return attribute.value;
+    }
+    return std::string_view();
+}
+
+// Namespace declarations and the xml: attributes that apply to the descendants of the element
+bool
+IsScopedAttribute(std::string_view name)
+{
+    return name == "xmlns" || name.compare(0, 6, "xmlns:") == 0 ||
+        name == "xml:space" || name == "xml:lang" || name == "xml:base";
+}
+
+bool
+ContainsAttribute(const std::vector<TagAttribute>& attributes, std::string_view name)
+{
+    return std::any_of(attributes.begin(), attributes.end(), [name](const TagAttribute& attribute) {
+        return attribute.name == name;
+    });
+}
+
+} // namespace
+
+MISO_INLINE bool
+XmlElementIndex::Build(const char* buffer, size_t size, const char* key_attribute_name, int max_depth)
+{
+    buffer_ = buffer;
+    size_ = size;
+    entries_.clear();
+    keys_.clear();
+    if (!Scan(key_attribute_name, max_depth)) {
+        entries_.clear();
+        keys_.clear();
+        content_begin_ = 0;
+        content_end_ = 0;
+        root_end_tag_.clear();
+        return false;
+    }
+    for (size_t i = 0; i < entries_.size(); ++i) {
+        if (entries_[i].key.data() != nullptr) keys_.emplace(entries_[i].key, i);
+    }
+    return true;
+}
+
+MISO_INLINE size_t
+XmlElementIndex::Find(std::string_view key) const
+{
+    auto found = keys_.find(key);
+    return (found != keys_.end()) ? found->second : kNotFound;
+}
+
+// Walks the markup with a stack of the open elements, which are kNotFound if deeper than max_depth.
+MISO_INLINE bool
+XmlElementIndex::Scan(const char* key_attribute_name, int max_depth)
+{
+    auto end = buffer_ + size_;
+    const char* begin;
+    const char* next = buffer_;
+    std::string_view key_name = (key_attribute_name != nullptr) ? key_attribute_name : "";
+    std::vector<size_t> open_entries;
+    while (true) {
+        auto type = FindNextMarkup(next, end, &begin, &next);
+        if (type == MarkupType::None) return false;
+
+        auto offset = static_cast<size_t>(begin - buffer_);
+        auto next_offset = static_cast<size_t>(next - buffer_);
+        if (type == MarkupType::EndTag) {
+            if (open_entries.empty()) return false;
+            if (open_entries.back() != kNotFound) entries_[open_entries.back()].end = next_offset;
+            open_entries.pop_back();
+            if (open_entries.empty()) {
+                content_end_ = offset;
+                return true;
+            }
+        } else if (type != MarkupType::Other) {
+            bool empty = (type == MarkupType::EmptyTag);
+            auto depth = static_cast<int>(open_entries.size());
+            auto name_end = FindEndOfName(begin + 1, next);
+            if (depth == 0) {
+                if (!entries_.empty()) return false;
+                content_begin_ = next_offset;
+                root_end_tag_ = empty ? std::string() : "</" + std::string(begin + 1, name_end) + ">";
+            }
+
+            auto entry_index = kNotFound;
+            if (depth <= max_depth) {
+                entry_index = entries_.size();
+                auto key = key_name.empty() ? std::string_view() : FindAttributeValue(name_end, next - 1, key_name);
+                auto parent = (depth > 0) ? open_entries.back() : kNotFound;
+                entries_.push_back(Entry{ offset, next_offset, depth, parent, key });
+            }
+            if (!empty) {
+                open_entries.push_back(entry_index);
+            } else if (depth == 0) {
+                content_end_ = next_offset;
+                return true;
+            }
+        }
+    }
+}
+
+// The declarations of the ancestors are added to the root start tag, replacing those of the same names.
+MISO_INLINE std::string
+XmlElementIndex::MakeScopePrefix(size_t index) const
+{
+    auto& root = entries_[0];
+    if (entries_[index].depth == 0) return std::string(buffer_, content_begin_);
+
+    auto end = buffer_ + size_;
+    std::vector<TagAttribute> scoped_attributes;
+    TagAttribute attribute;
+    for (auto i = entries_[index].parent; i != 0; i = entries_[i].parent) {
+        auto p = FindEndOfName(buffer_ + entries_[i].begin + 1, end);
+        auto tag_end = FindEndOfMarkup(p, end);
+        while (ReadAttribute(p, tag_end, &attribute)) {
+            // An inner declaration hides the outer ones of the name.
+            if (IsScopedAttribute(attribute.name) && !ContainsAttribute(scoped_attributes, attribute.name)) {
+                scoped_attributes.push_back(attribute);
+            }
+        }
+    }
+
+    auto p = FindEndOfName(buffer_ + root.begin + 1, end);
+    std::string prefix(buffer_, p);
+    while (ReadAttribute(p, buffer_ + content_begin_ - 1, &attribute)) {
+        if (!ContainsAttribute(scoped_attributes, attribute.name)) {
+            prefix += ' ';
+            prefix += attribute.text;
+        }
+    }
+    for (auto& scoped_attribute : scoped_attributes) {
+        prefix += ' ';
+        prefix += scoped_attribute.text;
+    }
+    prefix += '>';
+    return prefix;
+}
+
+MISO_INLINE
+XmlElementScanner::XmlElementScanner(const char* buffer, size_t size) :
+    buffer_(buffer),
+    size_(size)
+{}
+
+MISO_INLINE bool
+XmlElementScanner::Next()
+{
+    if (!empty_) ++depth_;
+    auto end = buffer_ + size_;
+    const char* begin;
+    const char* next = buffer_ + position_;
+    while (true) {
+        auto type = FindNextMarkup(next, end, &begin, &next);
+        if (type == MarkupType::None) return false;
+        position_ = static_cast<size_t>(next - buffer_);
+        if (type == MarkupType::EndTag) {
+            --depth_;
+        } else if (type != MarkupType::Other) {
+            begin_ = static_cast<size_t>(begin - buffer_);
+            empty_ = (type == MarkupType::EmptyTag);
+            if (depth_ == 0 && root_begin_ == kNotFound) root_begin_ = begin_;
+            return true;
+        }
+    }
+}
+
+MISO_INLINE bool
+XmlElementScanner::SkipElement()
+{
+    if (empty_) return true;
+    auto end = buffer_ + size_;
+    const char* begin;
+    const char* next = buffer_ + position_;
+    int depth = 1;
+    while (depth > 0) {
+        auto type = FindNextMarkup(next, end, &begin, &next);
+        if (type == MarkupType::None) return false;
+        if (type == MarkupType::StartTag) {
+            ++depth;
+        } else if (type == MarkupType::EndTag) {
+            --depth;
+        }
+    }
+    position_ = static_cast<size_t>(next - buffer_);
+    empty_ = true;
+    return true;
+}
+
+MISO_INLINE
+XmlFragmentStream::XmlFragmentStream(const XmlElementIndex& index, size_t begin, size_t end) :
+    XmlFragmentStream(std::string_view(index.GetBuffer(), index.GetContentBegin()),
+        std::string_view(index.GetBuffer() + begin, end - begin), index.GetRootEndTag())
+{}
+
+MISO_INLINE
+XmlFragmentStream::XmlFragmentStream(std::string prefix, const XmlElementIndex& index, size_t begin, size_t end) :
+    XmlFragmentStream(index, begin, end)
+{
+    prefix_ = std::move(prefix);
+    segments_[0] = Segment{ prefix_.data(), prefix_.size() };
+}
+
+MISO_INLINE
+XmlFragmentStream::XmlFragmentStream(std::string_view prefix, std::string_view body, std::string_view suffix) :
+    segments_{ { prefix.data(), prefix.size() }, { body.data(), body.size() }, { suffix.data(), suffix.size() } }
+{}
+
+MISO_INLINE uint8_t
+XmlFragmentStream::Read()
+{
+    uint8_t c;
+    return (ReadBlock(&c, 1) == 1) ? c : 0;
+}
+
+MISO_INLINE uint8_t
+XmlFragmentStream::Peek() const
+{
+    auto offset = position_;
+    for (auto& segment : segments_) {
+        if (offset < segment.size) return static_cast<uint8_t>(segment.data[offset]);
+        offset -= segment.size;
+    }
+    return 0;
+}
+
+MISO_INLINE size_t
+XmlFragmentStream::ReadBlock(uint8_t* buffer, size_t size)
+{
+    size_t read_size = 0;
+    size_t segment_begin = 0;
+    for (auto& segment : segments_) {
+        auto segment_end = segment_begin + segment.size;
+        if (position_ < segment_end && read_size < size) {
+            auto copy_size = std::min(segment_end - position_, size - read_size);
+            std::memcpy(buffer + read_size, segment.data + (position_ - segment_begin), copy_size);
+            position_ += copy_size;
+            read_size += copy_size;
+        }
+        segment_begin = segment_end;
+    }
+    MISO_STREAM_STATS_ONLY(stats_.delivered_bytes += read_size;)
+    return read_size;
+}
+
+MISO_INLINE void
+XmlFragmentStream::SetPosition(size_t position)
+{
+    MISO_STREAM_STATS_ONLY(++stats_.seek_count;)
+    position_ = std::min(position, GetSize());
+}
+
+} // namespace miso
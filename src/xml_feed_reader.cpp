@@ -0,0 +1,111 @@
+#include "miso/xml_feed_reader.hpp"
+
+#include <utility>
+
+namespace miso {
+
+MISO_INLINE
+XmlFeedReader::XmlFeedReader() :
+    parser_(*this)
+{
+    parser_.Begin();
+}
+
+MISO_INLINE bool
+XmlFeedReader::Feed(const char* data, size_t size)
+{
+    if (finished_) return false;
+    return parser_.Feed(data, size);
+}
+
+MISO_INLINE void
+XmlFeedReader::FinishFeeding()
+{
+    if (finished_) return;
+    finished_ = true;
+    parser_.End();
+}
+
+MISO_INLINE XmlReadResult
+XmlFeedReader::Read()
+{
+    // A start element is followed by its end if it has no child nodes.
+    bool waiting = nodes_.empty() ||
+        (nodes_.size() == 1 && nodes_.front().type == XmlNodeType::StartElement);
+    if (waiting && !finished_ && !parser_.IsStopped()) return XmlReadResult::NeedMoreData;
+    if (nodes_.empty()) {
+        node_.text.clear();
+        node_.attributes.clear();
+        return XmlReadResult::End;
+    }
+    node_ = std::move(nodes_.front());
+    nodes_.pop_front();
+    return XmlReadResult::Node;
+}
+
+MISO_INLINE std::string_view
+XmlFeedReader::GetElementNameView() const
+{
+    if (node_.type == XmlNodeType::StartElement ||
+        node_.type == XmlNodeType::EmptyElement ||
+        node_.type == XmlNodeType::EndElement) {
+        return node_.text;
+    }
+    return std::string_view();
+}
+
+MISO_INLINE std::string_view
+XmlFeedReader::GetContentTextView() const
+{
+    return (node_.type == XmlNodeType::Text) ? std::string_view(node_.text) : std::string_view();
+}
+
+MISO_INLINE std::string_view
+XmlFeedReader::GetAttributeValueView(const char* name) const
+{
+    for (auto& attribute : node_.attributes) {
+        if (attribute.GetName() == name) return attribute.GetValue();
+    }
+    return std::string_view();
+}
+
+MISO_INLINE void
+XmlFeedReader::OnStartElement(std::string_view name, ArrayView<XmlSaxAttribute> attributes)
+{
+    Node node;
+    node.type = XmlNodeType::StartElement;
+    node.depth = depth_++;
+    node.text.assign(name.data(), name.size());
+    node.attributes.reserve(attributes.GetCount());
+    for (auto& attribute : attributes) {
+        node.attributes.emplace_back(std::string(attribute.name), std::string(attribute.value));
+    }
+    nodes_.push_back(std::move(node));
+}
+
+MISO_INLINE void
+XmlFeedReader::OnEndElement(std::string_view name)
+{
+    --depth_;
+    if (!nodes_.empty() && nodes_.back().type == XmlNodeType::StartElement && nodes_.back().depth == depth_) {
+        nodes_.back().type = XmlNodeType::EmptyElement;
+        return;
+    }
+    Node node;
+    node.type = XmlNodeType::EndElement;
+    node.depth = depth_;
+    node.text.assign(name.data(), name.size());
+    nodes_.push_back(std::move(node));
+}
+
+MISO_INLINE void
+XmlFeedReader::OnText(std::string_view text)
+{
+    Node node;
+    node.type = XmlNodeType::Text;
+    node.depth = depth_;
+    node.text.assign(text.data(), text.size());
+    nodes_.push_back(std::move(node));
+}
+
+} // namespace miso
@@ -1,29 +1,192 @@
 #include "miso/xml_reader.hpp"
 
+#include <algorithm>
 #include <cstring>
+#include <mutex>
 #include <vector>
 
 #include "miso/string_utils.hpp"
+#include "miso/xml_element_index.hpp"
 
 namespace miso {
 
+namespace {
+
+bool
+IsTextNode(int type)
+{
+    return type == libxml::XML_READER_TYPE_TEXT ||
+        type == libxml::XML_READER_TYPE_CDATA ||
+        type == libxml::XML_READER_TYPE_WHITESPACE ||
+        type == libxml::XML_READER_TYPE_SIGNIFICANT_WHITESPACE;
+}
+
+const char*
+SkipSpaces(const char* s)
+{
+    while (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n') ++s;
+    return s;
+}
+
+// Parses a value of one item with the parser of the type, as Value does for each item.
+template<typename T>
+T
+ParseWhole(const char* str)
+{
+    auto s = SkipSpaces(str);
+    size_t consumed = 0;
+    auto parsed = T::TryParse(s, &consumed);
+    if (!parsed.IsValid() || *SkipSpaces(s + consumed) != '\0') return T::GetInvalid();
+    return parsed;
+}
+
+} // namespace
+
+MISO_INLINE int
+XmlReaderOptions::GetParserOptions() const
+{
+    return (no_blanks ? libxml::XML_PARSE_NOBLANKS : 0) |
+        (compact ? libxml::XML_PARSE_COMPACT : 0) |
+        (huge ? libxml::XML_PARSE_HUGE : 0) |
+        (no_cdata ? libxml::XML_PARSE_NOCDATA : 0);
+}
+
+// Names read by libxml are already in its dictionary,
+// except a prefixed name which is looked up by parts and so may differ from the one interned as a whole.
+MISO_INLINE XmlAtom
+XmlAtom::FromCurrentNode(libxml::xmlTextReaderPtr reader)
+{
+    auto name = libxml::xmlTextReaderConstName(reader);
+    if (name != nullptr && libxml::xmlTextReaderConstPrefix(reader) != nullptr) {
+        name = libxml::xmlTextReaderConstString(reader, name);
+    }
+    return XmlAtom(reinterpret_cast<const char*>(name));
+}
+
+MISO_INLINE size_t
+XmlAttributeFilter::Find(std::string_view name) const
+{
+    for (size_t i = 0; i < names_.size(); ++i) {
+        if (names_[i] == name) return i;
+    }
+    return kNotFound;
+}
+
+MISO_INLINE
+XmlAttributeCursor::XmlAttributeCursor(libxml::xmlTextReaderPtr reader, const XmlAttributeFilter* filter) :
+    reader_(reader),
+    filter_(filter)
+{}
+
+MISO_INLINE
+XmlAttributeCursor::XmlAttributeCursor(XmlAttributeCursor&& other) noexcept :
+    reader_(other.reader_),
+    filter_(other.filter_),
+    started_(other.started_),
+    on_attribute_(other.on_attribute_),
+    filter_index_(other.filter_index_),
+    found_count_(other.found_count_)
+{
+    other.reader_ = nullptr;
+    other.on_attribute_ = false;
+}
+
+MISO_INLINE bool
+XmlAttributeCursor::Next()
+{
+    while (reader_ != nullptr) {
+        if (filter_ != nullptr && found_count_ == filter_->GetCount()) {
+            // Every attribute in the filter has been visited
+            break;
+        }
+        auto result = started_ ?
+            libxml::xmlTextReaderMoveToNextAttribute(reader_) :
+            libxml::xmlTextReaderMoveToFirstAttribute(reader_);
+        started_ = true;
+        if (result != 1) break;
+        on_attribute_ = true;
+        if (filter_ == nullptr) return true;
+        filter_index_ = filter_->Find(GetName());
+        if (filter_index_ != XmlAttributeFilter::kNotFound) {
+            ++found_count_;
+            return true;
+        }
+    }
+    Finish();
+    return false;
+}
+
+MISO_INLINE std::string_view
+XmlAttributeCursor::GetName() const
+{
+    auto name = on_attribute_ ? reinterpret_cast<const char*>(libxml::xmlTextReaderConstName(reader_)) : nullptr;
+    return (name != nullptr) ? std::string_view(name) : std::string_view();
+}
+
+MISO_INLINE std::string_view
+XmlAttributeCursor::GetValue() const
+{
+    auto value = on_attribute_ ? reinterpret_cast<const char*>(libxml::xmlTextReaderConstValue(reader_)) : nullptr;
+    return (value != nullptr) ? std::string_view(value) : std::string_view();
+}
+
+MISO_INLINE XmlAtom
+XmlAttributeCursor::GetNameAtom() const
+{
+    return on_attribute_ ? XmlAtom::FromCurrentNode(reader_) : XmlAtom();
+}
+
+// Moves the reader back to the element.
+MISO_INLINE void
+XmlAttributeCursor::Finish()
+{
+    if (on_attribute_) {
+        libxml::xmlTextReaderMoveToElement(reader_);
+        on_attribute_ = false;
+    }
+    reader_ = nullptr;
+    filter_index_ = XmlAttributeFilter::kNotFound;
+}
+
 MISO_INLINE
-XmlReader::XmlReader(const char* filename) :
-    XmlReader(libxml::xmlParserInputBufferCreateFilename(filename, libxml::XML_CHAR_ENCODING_UTF8))
+XmlReader::XmlReader(const char* filename, const XmlReaderOptions& options) :
+    XmlReader(libxml::xmlParserInputBufferCreateFilename(filename, libxml::XML_CHAR_ENCODING_UTF8), options)
 {}
 
 MISO_INLINE
-XmlReader::XmlReader(const char* buffer, size_t size) :
-    XmlReader(libxml::xmlParserInputBufferCreateStatic(buffer, static_cast<int>(size), libxml::XML_CHAR_ENCODING_UTF8))
+XmlReader::XmlReader(const char* buffer, size_t size, const XmlReaderOptions& options) :
+    XmlReader(libxml::xmlParserInputBufferCreateStatic(buffer, static_cast<int>(size), libxml::XML_CHAR_ENCODING_UTF8), options)
+{
+    if (reader_ != nullptr) StartScan(buffer, size);
+}
+
+MISO_INLINE
+XmlReader::XmlReader(IStream& stream, const XmlReaderOptions& options) :
+    XmlReader(libxml::xmlParserInputBufferCreateIO(ReadStream, nullptr, &stream, libxml::XML_CHAR_ENCODING_UTF8), options)
 {}
 
 MISO_INLINE
-XmlReader::XmlReader(libxml::xmlParserInputBufferPtr buffer) :
+XmlReader::XmlReader(const XmlSubtree& subtree, const XmlReaderOptions& options) :
+    XmlReader(static_cast<libxml::xmlParserInputBufferPtr>(nullptr), options)
+{
+    Reset(subtree);
+}
+
+MISO_INLINE
+XmlReader::XmlReader(libxml::xmlParserInputBufferPtr buffer, const XmlReaderOptions& options) :
     buffer_(buffer),
-    reader_(libxml::xmlNewTextReader(buffer, nullptr)),
     node_type_(XmlNodeType::None),
-    reached_to_end_(false)
+    reached_to_end_(false),
+    options_(options)
 {
+    InitializeParser();
+    reader_ = libxml::xmlNewTextReader(buffer, nullptr);
+    // The parser is set up again with the options, reading the input from its beginning.
+    if (reader_ != nullptr && options_.GetParserOptions() != 0 &&
+        libxml::xmlTextReaderSetup(reader_, nullptr, nullptr, nullptr, options_.GetParserOptions()) != 0) {
+        libxml::xmlFreeTextReader(reader_);
+        reader_ = nullptr;
+    }
     if (reader_ != nullptr) {
         libxml::xmlTextReaderSetErrorHandler(reader_, ErrorHandler, this);
     } else {
@@ -33,10 +196,18 @@ XmlReader::XmlReader(libxml::xmlParserInputBufferPtr buffer) :
 
 MISO_INLINE
 XmlReader::XmlReader(XmlReader&& other) noexcept :
-    buffer_(other.buffer_), reader_(other.reader_)
+    buffer_(other.buffer_), fragment_stream_(std::move(other.fragment_stream_)), reader_(other.reader_),
+    node_type_(other.node_type_), reached_to_end_(other.reached_to_end_), errors_(std::move(other.errors_)),
+    options_(other.options_), text_(std::move(other.text_)), text_depth_(other.text_depth_),
+    has_pending_node_(other.has_pending_node_), pending_result_(other.pending_result_),
+    scan_buffer_(other.scan_buffer_), scanner_(std::move(other.scanner_)), scan_skips_(std::move(other.scan_skips_)),
+    scan_read_count_(other.scan_read_count_), attribute_values_(std::move(other.attribute_values_)),
+    attribute_value_texts_(std::move(other.attribute_value_texts_))
 {
     other.reader_ = nullptr;
     other.buffer_ = nullptr;
+    // The errors are reported to the object owning the reader.
+    if (reader_ != nullptr) libxml::xmlTextReaderSetErrorHandler(reader_, ErrorHandler, this);
 }
 
 MISO_INLINE
@@ -46,58 +217,378 @@ XmlReader::~XmlReader()
     libxml::xmlFreeParserInputBuffer(buffer_);
 }
 
+MISO_INLINE bool
+XmlReader::Reset(const char* filename)
+{
+    if (reader_ == nullptr) {
+        InitializeParser();
+        reader_ = libxml::xmlReaderForFile(filename, nullptr, options_.GetParserOptions());
+        return FinishReset((reader_ != nullptr) ? 0 : -1);
+    }
+    return FinishReset(libxml::xmlReaderNewFile(reader_, filename, nullptr, options_.GetParserOptions()));
+}
+
+MISO_INLINE bool
+XmlReader::Reset(const char* buffer, size_t size)
+{
+    int result;
+    if (reader_ == nullptr) {
+        InitializeParser();
+        reader_ = libxml::xmlReaderForMemory(buffer, static_cast<int>(size), nullptr, nullptr, options_.GetParserOptions());
+        result = (reader_ != nullptr) ? 0 : -1;
+    } else {
+        result = libxml::xmlReaderNewMemory(reader_, buffer, static_cast<int>(size), nullptr, nullptr, options_.GetParserOptions());
+    }
+    if (!FinishReset(result)) return false;
+    StartScan(buffer, size);
+    return true;
+}
+
+MISO_INLINE bool
+XmlReader::Reset(IStream& stream)
+{
+    if (reader_ == nullptr) {
+        InitializeParser();
+        reader_ = libxml::xmlReaderForIO(ReadStream, nullptr, &stream, nullptr, nullptr, options_.GetParserOptions());
+        return FinishReset((reader_ != nullptr) ? 0 : -1);
+    }
+    return FinishReset(libxml::xmlReaderNewIO(reader_, ReadStream, nullptr, &stream, nullptr, nullptr, options_.GetParserOptions()));
+}
+
+MISO_INLINE bool
+XmlReader::SeekToElement(const XmlElementIndex& index, std::string_view key)
+{
+    auto entry_index = index.Find(key);
+    if (entry_index == XmlElementIndex::kNotFound) return false;
+
+    // The root is read as the whole document, and another element as the only child of the root.
+    auto& entry = index.GetEntry(entry_index);
+    if (entry.depth == 0) {
+        return OpenFragment(std::make_unique<XmlFragmentStream>(index, index.GetContentBegin(), index.GetContentEnd()), false);
+    }
+    if (entry.parent == 0) {
+        return OpenFragment(std::make_unique<XmlFragmentStream>(index, entry.begin, entry.end), true);
+    }
+    // The root start tag declares what the ancestors between it and the element do.
+    return OpenFragment(std::make_unique<XmlFragmentStream>(index.MakeScopePrefix(entry_index), index, entry.begin, entry.end), true);
+}
+
+MISO_INLINE bool
+XmlReader::Reset(const XmlSubtree& subtree)
+{
+    if (subtree.IsNull()) return FinishReset(-1);
+    return OpenFragment(std::make_unique<XmlFragmentStream>(subtree.prefix_, subtree.GetSource(), subtree.suffix_), subtree.wrapped_);
+}
+
+// libxml sets up its global state once, which must not happen on several threads at the same time.
+MISO_INLINE void
+XmlReader::InitializeParser()
+{
+    static std::once_flag parser_initialized;
+    std::call_once(parser_initialized, [] { libxml::xmlInitParser(); });
+}
+
+// Reads the document of the stream, owned by the reader, up to the element in it.
+MISO_INLINE bool
+XmlReader::OpenFragment(std::unique_ptr<XmlFragmentStream> stream, bool wrapped)
+{
+    if (!Reset(*stream)) return false;
+    fragment_stream_ = std::move(stream);
+    if (wrapped && !Read()) return false;
+    if (!Read()) return false;
+    return node_type_ == XmlNodeType::StartElement || node_type_ == XmlNodeType::EmptyElement;
+}
+
+MISO_INLINE void
+XmlReader::Close()
+{
+    if (reader_ != nullptr) libxml::xmlTextReaderClose(reader_);
+    fragment_stream_.reset();
+    // The input given by the constructor is not owned by the reader.
+    libxml::xmlFreeParserInputBuffer(buffer_);
+    buffer_ = nullptr;
+    reached_to_end_ = true;
+}
+
+// The input of the previous document, if given by the constructor, is replaced by one owned by the reader.
+MISO_INLINE bool
+XmlReader::FinishReset(int result)
+{
+    node_type_ = XmlNodeType::None;
+    has_pending_node_ = false;
+    errors_.clear();
+    if (result != 0) {
+        Close();
+        errors_.push_back("Cannot open file");
+        return false;
+    }
+    libxml::xmlFreeParserInputBuffer(buffer_);
+    buffer_ = nullptr;
+    // The previous document is no longer read.
+    fragment_stream_.reset();
+    attribute_values_.clear();
+    attribute_value_texts_.clear();
+    StartScan(nullptr, 0);
+    reached_to_end_ = false;
+    libxml::xmlTextReaderSetErrorHandler(reader_, ErrorHandler, this);
+    return true;
+}
+
 MISO_INLINE bool
 XmlReader::Read()
 {
     if (reader_ == nullptr) return false;
 
     while (true) {
-        if (libxml::xmlTextReaderRead(reader_) != 1) {
+        if (ReadNode() != 1) {
             reached_to_end_ = true;
             return false;
         }
+        if (UpdateNodeType()) break;
+    }
+    return true;
+}
 
-        auto type = libxml::xmlTextReaderNodeType(reader_);
-        if (type == libxml::XML_READER_TYPE_ELEMENT) {
-            if (libxml::xmlTextReaderIsEmptyElement(reader_) == 1) {
-                node_type_ = XmlNodeType::EmptyElement;
-            } else {
-                node_type_ = XmlNodeType::StartElement;
+MISO_INLINE bool
+XmlReader::SkipSubtree()
+{
+    if (reader_ == nullptr) return false;
+    if (node_type_ != XmlNodeType::StartElement) return Read();
+
+    if (NextNode() != 1) {
+        reached_to_end_ = true;
+        return false;
+    }
+    return UpdateNodeType() || Read();
+}
+
+MISO_INLINE XmlSubtree
+XmlReader::CaptureSubtree()
+{
+    if (scan_buffer_ == nullptr) return XmlSubtree();
+    if (node_type_ != XmlNodeType::StartElement && node_type_ != XmlNodeType::EmptyElement) return XmlSubtree();
+    if (!SyncScanner()) return XmlSubtree();
+
+    XmlSubtree subtree;
+    subtree.begin_ = scanner_->GetBegin();
+    if (!BuildSubtreeContext(subtree) || !scanner_->SkipElement()) {
+        StartScan(nullptr, 0);
+        return XmlSubtree();
+    }
+    subtree.buffer_ = scan_buffer_;
+    subtree.end_ = scanner_->GetPosition();
+
+    // The scanner is already past the subtree, so the skip is not recorded.
+    if (node_type_ == XmlNodeType::EmptyElement) {
+        Read();
+        return subtree;
+    }
+    auto result = libxml::xmlTextReaderNext(reader_);
+    CountElement(result);
+    if (result != 1) {
+        reached_to_end_ = true;
+    } else if (!UpdateNodeType()) {
+        Read();
+    }
+    return subtree;
+}
+
+// A node read past by CoalesceText() is taken first.
+MISO_INLINE int
+XmlReader::ReadNode()
+{
+    if (has_pending_node_) {
+        has_pending_node_ = false;
+        return pending_result_;
+    }
+    auto result = libxml::xmlTextReaderRead(reader_);
+    CountElement(result);
+    return result;
+}
+
+MISO_INLINE int
+XmlReader::NextNode()
+{
+    if (has_pending_node_) return ReadNode();
+    if (scan_buffer_ != nullptr &&
+        libxml::xmlTextReaderNodeType(reader_) == libxml::XML_READER_TYPE_ELEMENT &&
+        libxml::xmlTextReaderIsEmptyElement(reader_) != 1) {
+        scan_skips_.push_back(scan_read_count_);
+        scan_read_count_ = 0;
+        if (scan_skips_.size() >= kMaxScanSkips) SyncScanner();
+    }
+    auto result = libxml::xmlTextReaderNext(reader_);
+    CountElement(result);
+    return result;
+}
+
+MISO_INLINE void
+XmlReader::CountElement(int result)
+{
+    if (scan_buffer_ != nullptr && result == 1 && libxml::xmlTextReaderNodeType(reader_) == libxml::XML_READER_TYPE_ELEMENT) {
+        ++scan_read_count_;
+    }
+}
+
+// Starts following the reader on the buffer if subtrees are captured, or stops with a null buffer.
+MISO_INLINE void
+XmlReader::StartScan(const char* buffer, size_t size)
+{
+    scan_buffer_ = options_.capture_subtrees ? buffer : nullptr;
+    scan_skips_.clear();
+    scan_read_count_ = 0;
+    if (scan_buffer_ == nullptr) return;
+    if (scanner_ == nullptr) scanner_ = std::make_unique<XmlElementScanner>();
+    *scanner_ = XmlElementScanner(buffer, size);
+}
+
+// Replays the recorded steps on the scanner, which then is at the current element.
+// The scanning stops if the buffer does not follow the reader.
+MISO_INLINE bool
+XmlReader::SyncScanner()
+{
+    bool synced = true;
+    for (auto read_count : scan_skips_) {
+        for (size_t i = 0; synced && i < read_count; ++i) synced = scanner_->Next();
+        synced = synced && scanner_->SkipElement();
+    }
+    for (size_t i = 0; synced && i < scan_read_count_; ++i) synced = scanner_->Next();
+    scan_skips_.clear();
+    scan_read_count_ = 0;
+    if (!synced) StartScan(nullptr, 0);
+    return synced;
+}
+
+// Makes the prolog and a parent declaring the namespaces in scope of the current element, found in libxml's tree.
+MISO_INLINE bool
+XmlReader::BuildSubtreeContext(XmlSubtree& subtree) const
+{
+    auto root_begin = scanner_->GetRootBegin();
+    auto node = libxml::xmlTextReaderCurrentNode(reader_);
+    if (root_begin == XmlElementScanner::kNotFound || node == nullptr) return false;
+
+    subtree.prefix_.assign(scan_buffer_, root_begin);
+    auto parent = node->parent;
+    subtree.wrapped_ = (parent != nullptr && parent->type == libxml::XML_ELEMENT_NODE);
+    if (!subtree.wrapped_) return true;
+
+    std::string name = reinterpret_cast<const char*>(parent->name);
+    if (parent->ns != nullptr && parent->ns->prefix != nullptr) {
+        name = std::string(reinterpret_cast<const char*>(parent->ns->prefix)) + ":" + name;
+    }
+    subtree.prefix_ += "<" + name;
+    std::vector<const libxml::xmlChar*> prefixes;
+    for (auto element = parent; element != nullptr && element->type == libxml::XML_ELEMENT_NODE; element = element->parent) {
+        for (auto ns = element->nsDef; ns != nullptr; ns = ns->next) {
+            // An inner declaration hides the outer ones of the prefix.
+            if (std::find_if(prefixes.begin(), prefixes.end(), [ns](const libxml::xmlChar* prefix) {
+                    return libxml::xmlStrEqual(prefix, ns->prefix) == 1;
+                }) != prefixes.end()) {
+                continue;
             }
-        } else if (type == libxml::XML_READER_TYPE_END_ELEMENT) {
-            node_type_ = XmlNodeType::EndElement;
-        } else if (type == libxml::XML_READER_TYPE_TEXT) {
-            node_type_ = XmlNodeType::Text;
+            prefixes.push_back(ns->prefix);
+            subtree.prefix_ += (ns->prefix != nullptr) ?
+                " xmlns:" + std::string(reinterpret_cast<const char*>(ns->prefix)) + "=\"" :
+                std::string(" xmlns=\"");
+            for (auto c = reinterpret_cast<const char*>(ns->href); c != nullptr && *c != '\0'; ++c) {
+                if (*c == '&') {
+                    subtree.prefix_ += "&amp;";
+                } else if (*c == '<') {
+                    subtree.prefix_ += "&lt;";
+                } else if (*c == '"') {
+                    subtree.prefix_ += "&quot;";
+                } else {
+                    subtree.prefix_ += *c;
+                }
+            }
+            subtree.prefix_ += "\"";
+        }
+    }
+    subtree.prefix_ += ">";
+    subtree.suffix_ = "</" + name + ">";
+    return true;
+}
+
+// Returns false if the current node is of a type not reported by XmlReader.
+MISO_INLINE bool
+XmlReader::UpdateNodeType()
+{
+    auto type = libxml::xmlTextReaderNodeType(reader_);
+    if (options_.coalesce_text && IsTextNode(type)) return CoalesceText();
+    if (type == libxml::XML_READER_TYPE_ELEMENT) {
+        if (libxml::xmlTextReaderIsEmptyElement(reader_) == 1) {
+            node_type_ = XmlNodeType::EmptyElement;
         } else {
-            continue;
+            node_type_ = XmlNodeType::StartElement;
         }
-        break;
+    } else if (type == libxml::XML_READER_TYPE_END_ELEMENT) {
+        node_type_ = XmlNodeType::EndElement;
+    } else if (type == libxml::XML_READER_TYPE_TEXT) {
+        node_type_ = XmlNodeType::Text;
+    } else {
+        return false;
     }
     return true;
 }
 
+// Reads the texts following the current one, leaving libxml at the node after them to be reported next.
+// Returns false if the texts are only of whitespace.
+MISO_INLINE bool
+XmlReader::CoalesceText()
+{
+    text_.clear();
+    text_depth_ = libxml::xmlTextReaderDepth(reader_);
+    int result;
+    do {
+        auto value = reinterpret_cast<const char*>(libxml::xmlTextReaderConstValue(reader_));
+        if (value != nullptr) text_ += value;
+        result = libxml::xmlTextReaderRead(reader_);
+        CountElement(result);
+    } while (result == 1 && IsTextNode(libxml::xmlTextReaderNodeType(reader_)));
+    has_pending_node_ = true;
+    pending_result_ = result;
+
+    if (text_.find_first_not_of(" \t\r\n") == std::string::npos) return false;
+    node_type_ = XmlNodeType::Text;
+    return true;
+}
+
 MISO_INLINE bool
 XmlReader::MoveToElement(const char* element_name, const char* attribute_name, const char* attribute_value)
 {
-    return MoveToElementInside(element_name, attribute_name, attribute_value, false);
+    return MoveToElementInside(element_name, XmlAtom(), attribute_name, attribute_value, false);
 }
 
 MISO_INLINE bool
 XmlReader::MoveToElementInCurrentLevel(const char* element_name, const char* attribute_name, const char* attribute_value)
 {
-    return MoveToElementInside(element_name, attribute_name, attribute_value, true);
+    return MoveToElementInside(element_name, XmlAtom(), attribute_name, attribute_value, true);
 }
 
 MISO_INLINE bool
-XmlReader::MoveToElementInside(const char* element_name, const char* attribute_name, const char* attribute_value, bool only_current_level)
+XmlReader::MoveToElement(XmlAtom element_atom, const char* attribute_name, const char* attribute_value)
 {
-    int count = 1;
-    if (node_type_ == XmlNodeType::StartElement) {
-        ++count;
-    }
+    return MoveToElementInside(nullptr, element_atom, attribute_name, attribute_value, false);
+}
+
+MISO_INLINE bool
+XmlReader::MoveToElementInCurrentLevel(XmlAtom element_atom, const char* attribute_name, const char* attribute_value)
+{
+    return MoveToElementInside(nullptr, element_atom, attribute_name, attribute_value, true);
+}
+
+MISO_INLINE bool
+XmlReader::MoveToElementInside(const char* element_name, XmlAtom element_atom, const char* attribute_name, const char* attribute_value, bool only_current_level)
+{
+    if (reader_ == nullptr) return false;
 
+    // In the current level, the subtree of every element passed is skipped by xmlTextReaderNext,
+    // so the nodes seen are the siblings and then the end of the parent.
+    auto result = only_current_level ?
+        NextNode() :
+        ReadNode();
     while (true) {
-        if (libxml::xmlTextReaderRead(reader_) != 1) {
+        if (result != 1) {
             reached_to_end_ = true;
             return false;
         }
@@ -106,39 +597,36 @@ XmlReader::MoveToElementInside(const char* element_name, const char* attribute_n
         if (type == libxml::XML_READER_TYPE_ELEMENT) {
             bool found = false;
             do {
-                if (only_current_level && count != 1) {
-                    break;
-                }
-                if (element_name != nullptr) {
+                if (!element_atom.IsNull()) {
+                    if (XmlAtom::FromCurrentNode(reader_) != element_atom) break;
+                } else if (element_name != nullptr) {
                     auto name = reinterpret_cast<const char*>(libxml::xmlTextReaderConstName(reader_));
                     if (name == nullptr || std::strcmp(element_name, name) != 0) break;
                 }
                 if (attribute_name != nullptr) {
-                    auto value = reinterpret_cast<char*>(
-                        libxml::xmlTextReaderGetAttribute(reader_, reinterpret_cast<const libxml::xmlChar*>(attribute_name)));
-                    if (value == nullptr ||
-                        (attribute_value != nullptr && std::strcmp(attribute_value, value) != 0)) {
-                        libxml::xmlFree(value);
+                    auto value = GetAttributeValueViewInside(attribute_name);
+                    if (value.data() == nullptr ||
+                        (attribute_value != nullptr && value != attribute_value)) {
                         break;
                     }
                 }
                 found = true;
             } while (false);
 
-            bool empty_element = (libxml::xmlTextReaderIsEmptyElement(reader_) == 1);
             if (found) {
+                bool empty_element = (libxml::xmlTextReaderIsEmptyElement(reader_) == 1);
                 node_type_ = empty_element ? XmlNodeType::EmptyElement : XmlNodeType::StartElement;
                 break;
             }
-            if (only_current_level && !empty_element) {
-                ++count;
-            }
         } else if (type == libxml::XML_READER_TYPE_END_ELEMENT) {
-            if (only_current_level && --count == 0) {
+            if (only_current_level) {
                 node_type_ = XmlNodeType::EndElement;
                 return false;
             }
         }
+        result = only_current_level ?
+            NextNode() :
+            ReadNode();
     }
 
     return true;
@@ -147,76 +635,162 @@ XmlReader::MoveToElementInside(const char* element_name, const char* attribute_n
 MISO_INLINE bool
 XmlReader::MoveToEndElementInside(bool end_of_parent)
 {
-    int count = 1;
+    if (reader_ == nullptr) return false;
+
+    int depth = GetNestingLevel();
+    int result;
     if (end_of_parent) {
-        if (node_type_ == XmlNodeType::StartElement) ++count;
+        --depth;
+        result = NextNode();
     } else {
         if (node_type_ != XmlNodeType::StartElement) return false;
+        result = ReadNode();
     }
 
+    // Every child element is skipped with its subtree, so only the nodes at depth + 1 and the end are seen.
     while (true) {
-        if (libxml::xmlTextReaderRead(reader_) != 1) {
+        if (result != 1) {
             reached_to_end_ = true;
             return false;
         }
-
-        auto type = libxml::xmlTextReaderNodeType(reader_);
-        if (type == libxml::XML_READER_TYPE_ELEMENT) {
-            if (libxml::xmlTextReaderIsEmptyElement(reader_) != 1) {
-                ++count;
-            }
-        } else if (type == libxml::XML_READER_TYPE_END_ELEMENT) {
-            if (--count == 0) {
-                node_type_ = XmlNodeType::EndElement;
-                break;
-            }
+        if (libxml::xmlTextReaderNodeType(reader_) == libxml::XML_READER_TYPE_END_ELEMENT &&
+            libxml::xmlTextReaderDepth(reader_) == depth) {
+            node_type_ = XmlNodeType::EndElement;
+            break;
         }
+        result = NextNode();
     }
 
     return true;
 }
 
-MISO_INLINE std::string
-XmlReader::GetElementName() const
+MISO_INLINE std::string_view
+XmlReader::GetElementNameView() const
 {
-    std::string name_str;
     if (node_type_ == XmlNodeType::StartElement ||
         node_type_ == XmlNodeType::EmptyElement ||
         node_type_ == XmlNodeType::EndElement) {
         auto name = reinterpret_cast<const char*>(libxml::xmlTextReaderConstName(reader_));
-        if (name != nullptr) name_str.assign(name);
+        if (name != nullptr) return std::string_view(name);
     }
-    return name_str;
+    return std::string_view();
 }
 
-
-MISO_INLINE std::string
-XmlReader::GetContentText() const
+MISO_INLINE std::string_view
+XmlReader::GetContentTextView() const
 {
-    std::string text_str;
     if (node_type_ == XmlNodeType::Text) {
+        if (options_.coalesce_text) return text_;
         auto text = reinterpret_cast<const char*>(libxml::xmlTextReaderConstValue(reader_));
-        if (text != nullptr) text_str.assign(text);
+        if (text != nullptr) return std::string_view(text);
     }
-    return text_str;
+    return std::string_view();
+}
+
+MISO_INLINE Value
+XmlReader::GetAttributeValue(const char* name) const
+{
+    auto value = GetAttributeValueView(name);
+    if (value.data() == nullptr) return Value();
+    // The view is of libxml's string, which ends with a null character.
+    auto cached = GetCachedValue(value);
+    return (cached != nullptr) ? *cached : Value(value.data());
 }
 
-MISO_INLINE const std::string
-XmlReader::GetAttributeValueString(const char* name) const
+MISO_INLINE Numeric
+XmlReader::GetAttributeNumeric(const char* name) const
+{
+    auto value = GetAttributeValueView(name);
+    if (value.data() == nullptr) return Numeric();
+    auto cached = GetCachedValue(value);
+    if (cached == nullptr) return ParseWhole<Numeric>(value.data());
+    return (cached->GetCount() == 1) ? cached->AsNumeric() : Numeric::GetInvalid();
+}
+
+MISO_INLINE Color
+XmlReader::GetAttributeColor(const char* name) const
+{
+    auto value = GetAttributeValueView(name);
+    if (value.data() == nullptr) return Color();
+    auto cached = GetCachedValue(value);
+    if (cached == nullptr) return ParseWhole<Color>(value.data());
+    return (cached->GetCount() == 1) ? cached->AsColor() : Color::GetInvalid();
+}
+
+// Returns nullptr if the cache is not used or is full, in which case the value is parsed in libxml's string.
+MISO_INLINE const Value*
+XmlReader::GetCachedValue(std::string_view value) const
+{
+    if (!options_.cache_attribute_values) return nullptr;
+    auto found = attribute_values_.find(value);
+    if (found != attribute_values_.end()) return &found->second;
+    if (attribute_values_.size() >= kMaxCachedValueCount) return nullptr;
+    auto& text = attribute_value_texts_.emplace_back(value);
+    return &attribute_values_.emplace(text, Value(text)).first->second;
+}
+
+MISO_INLINE bool
+XmlReader::ReadContentChunks(IXmlContentSink& sink, size_t chunk_size) const
+{
+    if (node_type_ != XmlNodeType::Text || chunk_size == 0) return false;
+    auto content = GetContentTextView();
+    size_t begin = 0;
+    while (begin < content.size()) {
+        auto end = begin + std::min(chunk_size, content.size() - begin);
+        // A chunk too small for a whole character is cut in the middle of it.
+        auto character_end = end;
+        while (character_end > begin && character_end < content.size() &&
+            (static_cast<unsigned char>(content[character_end]) & 0xC0) == 0x80) {
+            --character_end;
+        }
+        if (character_end > begin) end = character_end;
+        if (!sink.OnContentChunk(content.substr(begin, end - begin))) return false;
+        begin = end;
+    }
+    return true;
+}
+
+MISO_INLINE std::string_view
+XmlReader::GetAttributeValueView(const char* name) const
 {
-    std::string value_str;
     if (node_type_ == XmlNodeType::StartElement ||
         node_type_ == XmlNodeType::EmptyElement) {
-        auto value = reinterpret_cast<char*>(
-            libxml::xmlTextReaderGetAttribute(reader_, reinterpret_cast<const libxml::xmlChar*>(name)));
-        if (value != nullptr) {
-            value_str.assign(value);
-            libxml::xmlFree(value);
-        }
+        return GetAttributeValueViewInside(name);
     }
-    return value_str;
+    return std::string_view();
 }
 
+MISO_INLINE std::string_view
+XmlReader::GetAttributeValueViewInside(const char* name) const
+{
+    // Unlike xmlTextReaderGetAttribute, this does not duplicate the value.
+    std::string_view value_view;
+    if (libxml::xmlTextReaderMoveToAttribute(reader_, reinterpret_cast<const libxml::xmlChar*>(name)) == 1) {
+        auto value = reinterpret_cast<const char*>(libxml::xmlTextReaderConstValue(reader_));
+        value_view = (value != nullptr) ? std::string_view(value) : std::string_view("");
+        libxml::xmlTextReaderMoveToElement(reader_);
+    }
+    return value_view;
+}
+
+MISO_INLINE XmlAtom
+XmlReader::GetElementAtom() const
+{
+    if (node_type_ == XmlNodeType::StartElement ||
+        node_type_ == XmlNodeType::EmptyElement ||
+        node_type_ == XmlNodeType::EndElement) {
+        return XmlAtom::FromCurrentNode(reader_);
+    }
+    return XmlAtom();
+}
+
+MISO_INLINE XmlAtom
+XmlReader::Intern(const char* name) const
+{
+    if (reader_ == nullptr || name == nullptr) return XmlAtom();
+    auto atom = libxml::xmlTextReaderConstString(reader_, reinterpret_cast<const libxml::xmlChar*>(name));
+    return XmlAtom(reinterpret_cast<const char*>(atom));
+}
 
 MISO_INLINE const std::vector<XmlAttribute>
 XmlReader::GetAllAttributes() const
@@ -237,6 +811,20 @@ XmlReader::GetAllAttributes() const
     return attributes;
 }
 
+MISO_INLINE XmlAttributeCursor
+XmlReader::GetAttributeCursor(const XmlAttributeFilter* filter) const
+{
+    bool element = (node_type_ == XmlNodeType::StartElement || node_type_ == XmlNodeType::EmptyElement);
+    return XmlAttributeCursor(element ? reader_ : nullptr, filter);
+}
+
+MISO_INLINE int
+XmlReader::ReadStream(void* context, char* buffer, int size)
+{
+    auto& stream = *static_cast<IStream*>(context);
+    return static_cast<int>(stream.ReadBlock(reinterpret_cast<uint8_t*>(buffer), static_cast<size_t>(size)));
+}
+
 MISO_INLINE void
 XmlReader::ErrorHandler(void* arg, const char* msg, libxml::xmlParserSeverities severity, libxml::xmlTextReaderLocatorPtr locator)
 {
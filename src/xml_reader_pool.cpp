@@ -0,0 +1,59 @@
+#include "miso/xml_reader_pool.hpp"
+
+#include <utility>
+
+namespace miso {
+
+MISO_INLINE
+PooledXmlReader::~PooledXmlReader()
+{
+    if (reader_ != nullptr) pool_->Release(std::move(reader_));
+}
+
+MISO_INLINE XmlReaderPool&
+XmlReaderPool::GetForCurrentThread()
+{
+    thread_local XmlReaderPool pool;
+    return pool;
+}
+
+MISO_INLINE PooledXmlReader
+XmlReaderPool::Acquire(const char* filename)
+{
+    if (idle_readers_.empty()) return PooledXmlReader(*this, std::make_unique<XmlReader>(filename));
+    auto reader = std::move(idle_readers_.back());
+    idle_readers_.pop_back();
+    reader->Reset(filename);
+    return PooledXmlReader(*this, std::move(reader));
+}
+
+MISO_INLINE PooledXmlReader
+XmlReaderPool::Acquire(const char* buffer, size_t size)
+{
+    if (idle_readers_.empty()) return PooledXmlReader(*this, std::make_unique<XmlReader>(buffer, size));
+    auto reader = std::move(idle_readers_.back());
+    idle_readers_.pop_back();
+    reader->Reset(buffer, size);
+    return PooledXmlReader(*this, std::move(reader));
+}
+
+MISO_INLINE PooledXmlReader
+XmlReaderPool::Acquire(IStream& stream)
+{
+    if (idle_readers_.empty()) return PooledXmlReader(*this, std::make_unique<XmlReader>(stream));
+    auto reader = std::move(idle_readers_.back());
+    idle_readers_.pop_back();
+    reader->Reset(stream);
+    return PooledXmlReader(*this, std::move(reader));
+}
+
+// The document is released at once not to keep its file open in the pool.
+MISO_INLINE void
+XmlReaderPool::Release(std::unique_ptr<XmlReader> reader)
+{
+    if (idle_readers_.size() >= capacity_) return;
+    reader->Close();
+    idle_readers_.push_back(std::move(reader));
+}
+
+} // namespace miso
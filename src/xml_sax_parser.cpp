@@ -0,0 +1,238 @@
+#include "miso/xml_sax_parser.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "miso/file_stream.hpp"
+#include "miso/string_utils.hpp"
+
+namespace miso {
+
+namespace libxml {
+#include "libxml/parserInternals.h"
+}
+
+MISO_INLINE
+XmlSaxParser::~XmlSaxParser()
+{
+    libxml::xmlFreeParserCtxt(context_);
+}
+
+MISO_INLINE bool
+XmlSaxParser::Parse(const char* filename)
+{
+    FileStream stream(filename);
+    if (!stream.CanRead()) {
+        errors_.clear();
+        errors_.push_back("Cannot open file");
+        return false;
+    }
+    return Parse(stream);
+}
+
+MISO_INLINE bool
+XmlSaxParser::Parse(const char* buffer, size_t size)
+{
+    if (!Begin()) return false;
+    Feed(buffer, size);
+    return End();
+}
+
+MISO_INLINE bool
+XmlSaxParser::Parse(IStream& stream)
+{
+    if (!Begin()) return false;
+    std::vector<uint8_t> chunk(kChunkSize);
+    while (true) {
+        auto read_size = stream.ReadBlock(chunk.data(), chunk.size());
+        if (read_size == 0) break;
+        if (!Feed(reinterpret_cast<const char*>(chunk.data()), read_size)) break;
+    }
+    return End();
+}
+
+MISO_INLINE void
+XmlSaxParser::Stop()
+{
+    if (context_ != nullptr) libxml::xmlStopParser(context_);
+}
+
+MISO_INLINE bool
+XmlSaxParser::IsStopped() const
+{
+    return context_ == nullptr || context_->disableSAX != 0;
+}
+
+MISO_INLINE bool
+XmlSaxParser::Begin()
+{
+    libxml::xmlFreeParserCtxt(context_);
+    context_ = nullptr;
+    errors_.clear();
+    text_.clear();
+
+    libxml::xmlSAXHandler sax;
+    std::memset(&sax, 0, sizeof(sax));
+    sax.initialized = XML_SAX2_MAGIC;
+    sax.startElementNs = OnStartElementNs;
+    sax.endElementNs = OnEndElementNs;
+    sax.characters = OnCharacters;
+    sax.serror = OnStructuredError;
+    context_ = libxml::xmlCreatePushParserCtxt(&sax, this, nullptr, 0, nullptr);
+    if (context_ != nullptr && !UseDictionary()) {
+        libxml::xmlFreeParserCtxt(context_);
+        context_ = nullptr;
+    }
+    if (context_ == nullptr) {
+        errors_.push_back("Cannot create parser");
+        return false;
+    }
+    return true;
+}
+
+// Replaces the dictionary of the new context, which has interned only its predefined names, with one over the shared.
+// libxml looks names up in the shared dictionary without changing it, and counts its references under a lock.
+MISO_INLINE bool
+XmlSaxParser::UseDictionary()
+{
+    if (dictionary_ == nullptr || dictionary_->dict_ == nullptr) return true;
+    auto dict = libxml::xmlDictCreateSub(dictionary_->dict_);
+    if (dict == nullptr) return false;
+    libxml::xmlDictSetLimit(dict, XML_MAX_DICTIONARY_LIMIT);
+    libxml::xmlDictFree(context_->dict);
+    context_->dict = dict;
+    context_->str_xml = libxml::xmlDictLookup(dict, reinterpret_cast<const libxml::xmlChar*>("xml"), 3);
+    context_->str_xmlns = libxml::xmlDictLookup(dict, reinterpret_cast<const libxml::xmlChar*>("xmlns"), 5);
+    context_->str_xml_ns = libxml::xmlDictLookup(dict, reinterpret_cast<const libxml::xmlChar*>("http://www.w3.org/XML/1998/namespace"), 36);
+    return true;
+}
+
+MISO_INLINE bool
+XmlSaxParser::Feed(const char* data, size_t size)
+{
+    if (context_ == nullptr) return false;
+    // libxml takes the size as int.
+    const size_t max_size = 1 << 30;
+    while (size > max_size) {
+        if (!FeedChunk(data, max_size, false)) return false;
+        data += max_size;
+        size -= max_size;
+    }
+    return FeedChunk(data, size, false);
+}
+
+// Tells the end of the document to the parser, which does nothing more if it has been stopped.
+MISO_INLINE bool
+XmlSaxParser::End()
+{
+    if (context_ == nullptr) return !HasError();
+    FeedChunk(nullptr, 0, true);
+    libxml::xmlFreeParserCtxt(context_);
+    context_ = nullptr;
+    text_.clear();
+    return !HasError();
+}
+
+// Returns false if parsing has been stopped.
+MISO_INLINE bool
+XmlSaxParser::FeedChunk(const char* data, size_t size, bool terminate)
+{
+    libxml::xmlParseChunk(context_, data, static_cast<int>(size), terminate ? 1 : 0);
+    return context_->disableSAX == 0;
+}
+
+MISO_INLINE void
+XmlSaxParser::FlushText()
+{
+    if (text_.empty()) return;
+    auto not_space = [](char c) { return c != ' ' && c != '\t' && c != '\r' && c != '\n'; };
+    if (std::find_if(text_.begin(), text_.end(), not_space) != text_.end()) {
+        handler_.OnText(text_);
+    }
+    text_.clear();
+}
+
+MISO_INLINE void
+XmlSaxParser::OnStartElementNs(void* context, const libxml::xmlChar* local_name, const libxml::xmlChar* prefix, const libxml::xmlChar* uri,
+    int namespace_count, const libxml::xmlChar** namespaces, int attribute_count, int defaulted_count, const libxml::xmlChar** attributes)
+{
+    (void)uri;
+    (void)namespace_count;
+    (void)namespaces;
+    (void)defaulted_count;
+    auto& parser = *static_cast<XmlSaxParser*>(context);
+    parser.FlushText();
+
+    // Each attribute is given as local name, prefix, URI, value and end of value.
+    auto count = static_cast<size_t>(attribute_count);
+    parser.attributes_.resize(count);
+    if (parser.attribute_names_.size() < count) {
+        parser.attribute_names_.resize(count);
+        parser.attribute_values_.resize(count);
+    }
+    for (size_t i = 0; i < count; ++i) {
+        auto attribute = attributes + i * 5;
+        auto value = reinterpret_cast<const char*>(attribute[3]);
+        auto value_end = reinterpret_cast<const char*>(attribute[4]);
+        parser.attributes_[i].name = MakeName(attribute[0], attribute[1], parser.attribute_names_[i]);
+        parser.attributes_[i].value = DecodeValue(value, value_end, parser.attribute_values_[i]);
+    }
+    auto name = MakeName(local_name, prefix, parser.name_);
+    parser.handler_.OnStartElement(name, ArrayView<XmlSaxAttribute>(parser.attributes_.data(), count));
+}
+
+MISO_INLINE void
+XmlSaxParser::OnEndElementNs(void* context, const libxml::xmlChar* local_name, const libxml::xmlChar* prefix, const libxml::xmlChar* uri)
+{
+    (void)uri;
+    auto& parser = *static_cast<XmlSaxParser*>(context);
+    parser.FlushText();
+    parser.handler_.OnEndElement(MakeName(local_name, prefix, parser.name_));
+}
+
+MISO_INLINE void
+XmlSaxParser::OnCharacters(void* context, const libxml::xmlChar* text, int length)
+{
+    auto& parser = *static_cast<XmlSaxParser*>(context);
+    parser.text_.append(reinterpret_cast<const char*>(text), static_cast<size_t>(length));
+}
+
+MISO_INLINE void
+XmlSaxParser::OnStructuredError(void* context, ErrorPointer error)
+{
+    auto& parser = *static_cast<XmlSaxParser*>(context);
+    auto severity_label = (error->level == libxml::XML_ERR_WARNING) ? "WARNING" : "ERROR";
+    auto message = StringUtils::Trim((error->message != nullptr) ? error->message : "");
+    parser.errors_.push_back(StringUtils::Format("[%s] %s", severity_label, message.c_str()));
+}
+
+// A prefixed name is built in the buffer, otherwise the local name is returned as is.
+MISO_INLINE std::string_view
+XmlSaxParser::MakeName(const libxml::xmlChar* local_name, const libxml::xmlChar* prefix, std::string& buffer)
+{
+    if (prefix == nullptr) return std::string_view(reinterpret_cast<const char*>(local_name));
+    buffer.assign(reinterpret_cast<const char*>(prefix));
+    buffer += ':';
+    buffer += reinterpret_cast<const char*>(local_name);
+    return buffer;
+}
+
+// Without entity substitution, libxml gives '&' in an attribute value as "&#38;" to be decoded by the tree builder.
+MISO_INLINE std::string_view
+XmlSaxParser::DecodeValue(const char* value, const char* value_end, std::string& buffer)
+{
+    std::string_view view(value, static_cast<size_t>(value_end - value));
+    auto position = view.find("&#38;");
+    if (position == std::string_view::npos) return view;
+    buffer.clear();
+    while (position != std::string_view::npos) {
+        buffer.append(view.data(), position);
+        buffer += '&';
+        view.remove_prefix(position + 5);
+        position = view.find("&#38;");
+    }
+    buffer.append(view.data(), view.size());
+    return buffer;
+}
+
+} // namespace miso
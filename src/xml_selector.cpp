@@ -0,0 +1,272 @@
+#include "miso/xml_selector.hpp"
+
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+#include "miso/string_utils.hpp"
+
+namespace miso {
+
+MISO_INLINE
+XmlSelector::XmlSelector(const char* selector)
+{
+    Compile(selector);
+}
+
+MISO_INLINE bool
+XmlSelector::Compile(const char* selector)
+{
+    if (selector == nullptr) selector = "";
+    auto p = selector;
+    auto skip_spaces = [&p]() {
+        auto begin = p;
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') ++p;
+        return p != begin;
+    };
+    auto skip_name = [&p]() {
+        auto begin = p;
+        while (*p != '\0' && std::strchr(" \t\r\n>[]=@'\"", *p) == nullptr) ++p;
+        return std::string(begin, p);
+    };
+    auto fail = [this, &p, selector](const char* message) {
+        error_ = StringUtils::Format("%s at %d in \"%s\"", message, static_cast<int>(p - selector), selector);
+        steps_.clear();
+        predicates_.clear();
+        return false;
+    };
+
+    skip_spaces();
+    bool is_child = false;
+    if (*p == '>') {
+        is_child = true;
+        ++p;
+        skip_spaces();
+    }
+    while (true) {
+        Step step;
+        step.is_child = is_child;
+        step.element_name = skip_name();
+        if (step.element_name.empty()) return fail("Element name expected");
+        if (step.element_name == "*") step.element_name.clear();
+
+        step.predicate_begin = predicates_.size();
+        while (*p == '[') {
+            ++p;
+            skip_spaces();
+            if (*p != '@') return fail("'@' expected");
+            ++p;
+            Predicate predicate;
+            predicate.attribute_name = skip_name();
+            if (predicate.attribute_name.empty()) return fail("Attribute name expected");
+            skip_spaces();
+            if (*p == '=') {
+                ++p;
+                skip_spaces();
+                auto quote = *p;
+                if (quote != '\'' && quote != '"') return fail("Quoted value expected");
+                auto value_begin = ++p;
+                while (*p != '\0' && *p != quote) ++p;
+                if (*p == '\0') return fail("Unterminated value");
+                predicate.attribute_value.assign(value_begin, p);
+                predicate.has_value = true;
+                ++p;
+                skip_spaces();
+            }
+            if (*p != ']') return fail("']' expected");
+            ++p;
+            predicates_.push_back(std::move(predicate));
+        }
+        step.predicate_end = predicates_.size();
+        steps_.push_back(std::move(step));
+        if (steps_.size() > kMaxStepCount) return fail("Too many steps");
+
+        bool spaced = skip_spaces();
+        if (*p == '\0') break;
+        if (*p == '>') {
+            is_child = true;
+            ++p;
+            skip_spaces();
+        } else if (spaced) {
+            is_child = false;
+        } else {
+            return fail("Unexpected character");
+        }
+    }
+    return true;
+}
+
+MISO_INLINE
+XmlSelection::XmlSelection(XmlReader& reader, const XmlSelector& selector) :
+    reader_(reader),
+    selector_(selector),
+    final_state_(static_cast<States>(1) << selector.steps_.size())
+{
+    auto libxml_reader = reader_.reader_;
+    if (libxml_reader == nullptr || !selector_.IsValid()) {
+        finished_ = true;
+        return;
+    }
+
+    auto intern = [libxml_reader](const std::string& name) {
+        return name.empty() ? nullptr :
+            libxml::xmlTextReaderConstString(libxml_reader, reinterpret_cast<const libxml::xmlChar*>(name.c_str()));
+    };
+    for (auto& step : selector_.steps_) {
+        element_atoms_.push_back(intern(step.element_name));
+    }
+    for (auto& predicate : selector_.predicates_) {
+        attribute_atoms_.push_back(intern(predicate.attribute_name));
+    }
+
+    if (reader_.node_type_ == XmlNodeType::None) {
+        scope_depth_ = -1;
+    } else if (reader_.node_type_ == XmlNodeType::StartElement) {
+        scope_depth_ = reader_.GetNestingLevel();
+    } else {
+        scope_depth_ = reader_.GetNestingLevel() - 1;
+    }
+}
+
+MISO_INLINE bool
+XmlSelection::Next()
+{
+    if (finished_) return false;
+    // The reader may have been moved since the last call, and libxml may have freed the nodes recorded
+    // and reused their memory, so the states are found again along the parents.
+    entries_.clear();
+
+    auto reader = reader_.reader_;
+    int result;
+    if (!started_) {
+        started_ = true;
+        result = reader_.ReadNode();
+    } else if (reader_.node_type_ == XmlNodeType::StartElement) {
+        // The subtree of the element selected last is read only if it can contain another one.
+        auto node = libxml::xmlTextReaderCurrentNode(reader);
+        auto states = GetStates(node, libxml::xmlTextReaderDepth(reader) - scope_depth_);
+        result = ((states & ~final_state_) != 0) ?
+            reader_.ReadNode() :
+            reader_.NextNode();
+    } else {
+        result = reader_.ReadNode();
+    }
+
+    while (true) {
+        if (result != 1) {
+            reader_.reached_to_end_ = true;
+            finished_ = true;
+            return false;
+        }
+
+        auto type = libxml::xmlTextReaderNodeType(reader);
+        if (type == libxml::XML_READER_TYPE_ELEMENT) {
+            auto relative_depth = libxml::xmlTextReaderDepth(reader) - scope_depth_;
+            if (relative_depth <= 0) {
+                // The reader has been moved out of the scope.
+                reader_.UpdateNodeType();
+                finished_ = true;
+                return false;
+            }
+            auto node = libxml::xmlTextReaderCurrentNode(reader);
+            auto states = Advance(GetStates(node->parent, relative_depth - 1), node);
+            if (entries_.size() <= static_cast<size_t>(relative_depth)) entries_.resize(relative_depth + 1);
+            entries_[relative_depth].node = node;
+            entries_[relative_depth].states = states;
+            if ((states & final_state_) != 0) {
+                reader_.UpdateNodeType();
+                return true;
+            }
+            bool empty_element = (libxml::xmlTextReaderIsEmptyElement(reader) == 1);
+            result = ((states & ~final_state_) != 0 && !empty_element) ?
+                reader_.ReadNode() :
+                reader_.NextNode();
+        } else if (type == libxml::XML_READER_TYPE_END_ELEMENT &&
+            libxml::xmlTextReaderDepth(reader) <= scope_depth_) {
+            reader_.UpdateNodeType();
+            finished_ = true;
+            return false;
+        } else {
+            result = reader_.ReadNode();
+        }
+    }
+}
+
+// Returns the states of an ancestor, computing them again if the cached entry is of another node.
+MISO_INLINE XmlSelection::States
+XmlSelection::GetStates(const libxml::xmlNode* node, int relative_depth)
+{
+    if (relative_depth <= 0 || node == nullptr) return 1;
+    if (static_cast<size_t>(relative_depth) < entries_.size() && entries_[relative_depth].node == node) {
+        return entries_[relative_depth].states;
+    }
+    auto states = Advance(GetStates(node->parent, relative_depth - 1), node);
+    if (entries_.size() <= static_cast<size_t>(relative_depth)) entries_.resize(relative_depth + 1);
+    entries_[relative_depth].node = node;
+    entries_[relative_depth].states = states;
+    return states;
+}
+
+MISO_INLINE XmlSelection::States
+XmlSelection::Advance(States parent_states, const libxml::xmlNode* node) const
+{
+    States states = 0;
+    auto& steps = selector_.steps_;
+    for (size_t i = 0; i < steps.size(); ++i) {
+        auto state = static_cast<States>(1) << i;
+        if ((parent_states & state) == 0) continue;
+        if (!steps[i].is_child) states |= state;
+        if (MatchesStep(i, node)) states |= state << 1;
+    }
+    return states;
+}
+
+MISO_INLINE bool
+XmlSelection::MatchesStep(size_t step_index, const libxml::xmlNode* node) const
+{
+    auto& step = selector_.steps_[step_index];
+    auto element_atom = element_atoms_[step_index];
+    if (element_atom != nullptr && !MatchesName(node->name, node->ns, element_atom)) return false;
+
+    for (auto i = step.predicate_begin; i < step.predicate_end; ++i) {
+        auto& predicate = selector_.predicates_[i];
+        auto attribute = node->properties;
+        while (attribute != nullptr && !MatchesName(attribute->name, attribute->ns, attribute_atoms_[i])) {
+            attribute = attribute->next;
+        }
+        if (attribute == nullptr) return false;
+        if (predicate.has_value && !MatchesValue(attribute, predicate.attribute_value)) return false;
+    }
+    return true;
+}
+
+// Names in a document read by XmlReader are in the same dictionary as the atoms,
+// but a prefixed name is stored as its parts.
+MISO_INLINE bool
+XmlSelection::MatchesName(const libxml::xmlChar* name, const libxml::xmlNs* ns, const libxml::xmlChar* atom)
+{
+    if (ns == nullptr || ns->prefix == nullptr) return name == atom;
+    auto prefix_length = libxml::xmlStrlen(ns->prefix);
+    return libxml::xmlStrncmp(atom, ns->prefix, prefix_length) == 0 &&
+        atom[prefix_length] == ':' &&
+        libxml::xmlStrEqual(atom + prefix_length + 1, name);
+}
+
+MISO_INLINE bool
+XmlSelection::MatchesValue(const libxml::xmlAttr* attribute, const std::string& value)
+{
+    auto child = attribute->children;
+    if (child == nullptr) return value.empty();
+    if (child->next == nullptr && child->type == libxml::XML_TEXT_NODE) {
+        auto content = reinterpret_cast<const char*>(child->content);
+        return (content != nullptr) ? (value == content) : value.empty();
+    }
+
+    // The value contains entity references.
+    auto text = libxml::xmlNodeListGetString(attribute->doc, child, 1);
+    bool matched = (text != nullptr) ? (value == reinterpret_cast<const char*>(text)) : value.empty();
+    libxml::xmlFree(text);
+    return matched;
+}
+
+} // namespace miso
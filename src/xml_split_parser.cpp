@@ -0,0 +1,56 @@
+#include "miso/xml_split_parser.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace miso {
+
+MISO_INLINE
+XmlSplitParser::XmlSplitParser(const char* buffer, size_t size) :
+    buffer_(buffer),
+    size_(size)
+{}
+
+MISO_INLINE bool
+XmlSplitParser::Split(size_t part_count)
+{
+    parts_.clear();
+    if (!index_.Build(buffer_, size_, nullptr, 1)) {
+        parts_.push_back(Part{ 0, size_ });
+        return false;
+    }
+
+    // A part is closed at the first child after it has reached the size.
+    auto content_begin = index_.GetContentBegin();
+    auto content_end = index_.GetContentEnd();
+    auto part_size = std::max<size_t>((content_end - content_begin) / std::max<size_t>(part_count, 1), 1);
+    auto part_begin = content_begin;
+    for (size_t i = 1; i < index_.GetCount(); ++i) {
+        auto offset = index_.GetEntry(i).begin;
+        if (offset - part_begin >= part_size) {
+            parts_.push_back(Part{ part_begin, offset });
+            part_begin = offset;
+        }
+    }
+    parts_.push_back(Part{ part_begin, content_end });
+    return true;
+}
+
+MISO_INLINE bool
+XmlSplitParser::Run(IXmlBatchVisitor& visitor, size_t thread_count)
+{
+    if (parts_.empty()) {
+        auto split_count = (thread_count != 0) ? thread_count : std::max(std::thread::hardware_concurrency(), 1u);
+        Split(split_count * kPartsPerThread);
+    }
+
+    streams_.clear();
+    batch_ = std::make_unique<XmlBatch>();
+    for (auto& part : parts_) {
+        streams_.push_back(std::make_unique<XmlFragmentStream>(index_, part.begin, part.end));
+        batch_->AddStream(*streams_.back());
+    }
+    return batch_->Run(visitor, thread_count);
+}
+
+} // namespace miso